@@ -0,0 +1,25 @@
+/*  Общие помощники замеров из testing/bench.cpp: время с заданного момента
+    и случайные строки над маленьким алфавитом.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <string>
+
+// секунды, прошедшие с start
+double seconds(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+}
+
+// случайная строка над первыми letters буквами
+std::string randomString(std::mt19937& rng, int size, int letters){
+    std::string result(size, 'a');
+    for(int i = 0; i < size; ++i){
+        result[i] = 'a' + rng() % letters;
+    }
+    return result;
+}
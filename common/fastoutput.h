@@ -0,0 +1,128 @@
+/*  Буферизованный вывод целых чисел:
+    числа переводятся в текст по две цифры за раз через таблицу "00".."99",
+    складываются в большой буфер и сбрасываются одним вызовом write() на буфер.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+class OutputWriter
+{
+public:
+    // fd == 1 - stdout
+    explicit OutputWriter(int fd = 1, size_t capacity = 1 << 20);
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void write(long long value);
+    void write(int value);
+    void write(char chr);
+    void write(std::string_view str);
+
+    void flush();
+
+private:
+    void writeAll(const char* data, size_t size);
+
+    // сколько байт гарантированно хватает на одно число
+    static const int NUMBER_SIZE = 24;
+
+    int _fd;
+    std::vector< char > _buffer;
+    size_t _size = 0;
+};
+
+
+OutputWriter::OutputWriter(int fd, size_t capacity) : _fd(fd), _buffer(std::max< size_t >(capacity, NUMBER_SIZE)) {}
+
+OutputWriter::~OutputWriter(){
+    flush();
+}
+
+void OutputWriter::flush(){
+    writeAll(_buffer.data(), _size);
+    _size = 0;
+}
+
+void OutputWriter::writeAll(const char* data, size_t size){
+    size_t written = 0;
+    while(written < size){
+        ssize_t got = ::write(_fd, data + written, size - written);
+        if(got <= 0){
+            break;
+        }
+        written += got;
+    }
+}
+
+void OutputWriter::write(long long value){
+    static const char DIGITS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    if(_size + NUMBER_SIZE > _buffer.size()){
+        flush();
+    }
+
+    unsigned long long rest = value;
+    if(value < 0){
+        _buffer[_size++] = '-';
+        rest = 0ull - rest;
+    }
+
+    // пишем цифры с конца во временный массив, затем одним memcpy в буфер
+    char digits[NUMBER_SIZE];
+    char* end = digits + NUMBER_SIZE;
+    char* pos = end;
+
+    while(rest >= 100){
+        unsigned idx = (rest % 100) * 2;
+        rest /= 100;
+        *--pos = DIGITS[idx + 1];
+        *--pos = DIGITS[idx];
+    }
+    if(rest >= 10){
+        *--pos = DIGITS[rest * 2 + 1];
+        *--pos = DIGITS[rest * 2];
+    } else {
+        *--pos = '0' + rest;
+    }
+
+    std::memcpy(_buffer.data() + _size, pos, end - pos);
+    _size += end - pos;
+}
+
+void OutputWriter::write(int value){
+    write(static_cast< long long >(value));
+}
+
+void OutputWriter::write(char chr){
+    if(_size == _buffer.size()){
+        flush();
+    }
+    _buffer[_size++] = chr;
+}
+
+void OutputWriter::write(std::string_view str){
+    if(_size + str.size() > _buffer.size()){
+        flush();
+    }
+    if(str.size() > _buffer.size()){
+        // длинная строка идет мимо буфера
+        writeAll(str.data(), str.size());
+        return;
+    }
+    std::memcpy(_buffer.data() + _size, str.data(), str.size());
+    _size += str.size();
+}
@@ -0,0 +1,279 @@
+/*  Сжатый полнотекстовый индекс (FM-индекс), который строится по готовому
+    суффиксному массиву: преобразование Барроуза-Уилера (BWT) в вейвлет-дереве
+    с rank за O(log σ) и выборка суффиксного массива - запоминаются позиции,
+    кратные sampleRate. count идет обратным поиском за O(m log σ), locate
+    для каждого вхождения делает до sampleRate - 1 шагов LF.
+    Сам текст после построения не нужен. Память около 1.1n байт на BWT
+    и n / 8 байт на метки выборки плюс n / sampleRate индексов: sampleRate
+    меняет память на время locate.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "rankbitvector.h"
+
+//  Вейвлет-дерево над байтами в виде вейвлет-матрицы: 8 уровней по n бит,
+//  без указателей. на уровне k последовательность устойчиво разбита по
+//  k-му сверху биту предыдущего уровня - нули в начале, единицы в конце
+class WaveletTree
+{
+public:
+    WaveletTree() = default;
+    explicit WaveletTree(const std::vector< unsigned char >& values);
+
+    // число символов c в [0, i)
+    size_t rank(unsigned char c, size_t i) const;
+
+    // values[i], в rank - число таких же символов в [0, i)
+    unsigned char access(size_t i, size_t& rank) const;
+
+    size_t memoryUsage() const;
+
+private:
+    static const int LEVELS = 8;
+
+    RankBitVector _levels[LEVELS];
+    size_t _zeros[LEVELS] = {};
+
+    // куда путь символа c приводит позицию 0: там после последнего уровня
+    // начинаются символы c, и rank - расстояние от этой точки
+    size_t _begin[256] = {};
+};
+
+//  Index - тип индексов: int для строк короче 2^31, long long для длинных
+template< class Index = int >
+class FMIndex
+{
+public:
+    FMIndex() = default;
+
+    // suffArray - суффиксный массив text вместе с пустым суффиксом в начале,
+    // как у ProblemSolver::suffixArray(). запоминаются позиции суффиксов,
+    // кратные sampleRate
+    template< class Array >
+    FMIndex(std::string_view text, const Array& suffArray, int sampleRate = 32);
+
+    // число вхождений pattern, пустой шаблон входит во все n + 1 позиций
+    Index count(std::string_view pattern) const;
+
+    // позиции всех вхождений pattern по возрастанию
+    void locate(std::string_view pattern, std::vector< Index >& positions) const;
+
+    int sampleRate() const;
+    size_t memoryUsage() const;
+
+private:
+    // отрезок [begin, end) строк матрицы BWT, которые начинаются с pattern
+    void search(std::string_view pattern, Index& begin, Index& end) const;
+
+    // число символов c в BWT[0, i) без терминального символа
+    Index occurrences(unsigned char c, Index i) const;
+
+    // строка суффикса на единицу левее суффикса строки row
+    Index previousRow(Index row) const;
+
+    Index _size = 0;
+    // строка суффикса 0: в BWT на ее месте терминальный символ, который
+    // хранится как '\0' и вычитается из rank
+    Index _primary = 0;
+    int _sampleRate = 1;
+
+    WaveletTree _bwt;
+    // _first[c] - первая строка суффиксов, начинающихся с c
+    std::vector< Index > _first;
+
+    // отмечены строки, суффиксы которых начинаются в позициях, кратных
+    // _sampleRate; _samples - эти позиции в порядке строк
+    RankBitVector _sampled;
+    std::vector< Index > _samples;
+};
+
+
+WaveletTree::WaveletTree(const std::vector< unsigned char >& values){
+    std::vector< unsigned char > current(values);
+    std::vector< unsigned char > next(values.size());
+
+    for(int level = 0; level < LEVELS; ++level){
+        int bit = LEVELS - 1 - level;
+        RankBitVector& bits = _levels[level];
+        bits = RankBitVector(current.size());
+
+        size_t zeros = 0;
+        for(size_t i = 0; i < current.size(); ++i){
+            if((current[i] >> bit) & 1){
+                bits.set(i);
+            } else {
+                ++zeros;
+            }
+        }
+        bits.buildRank();
+        _zeros[level] = zeros;
+
+        //  устойчивое разбиение: нули по порядку в начало, единицы за ними
+        size_t zero = 0;
+        size_t one = zeros;
+        for(size_t i = 0; i < current.size(); ++i){
+            next[((current[i] >> bit) & 1) ? one++ : zero++] = current[i];
+        }
+        current.swap(next);
+    }
+
+    for(int c = 0; c < 256; ++c){
+        size_t position = 0;
+        for(int level = 0; level < LEVELS; ++level){
+            if((c >> (LEVELS - 1 - level)) & 1){
+                position = _zeros[level] + _levels[level].rank1(position);
+            } else {
+                position = _levels[level].rank0(position);
+            }
+        }
+        _begin[c] = position;
+    }
+}
+
+size_t WaveletTree::rank(unsigned char c, size_t i) const {
+    for(int level = 0; level < LEVELS; ++level){
+        if((c >> (LEVELS - 1 - level)) & 1){
+            i = _zeros[level] + _levels[level].rank1(i);
+        } else {
+            i = _levels[level].rank0(i);
+        }
+    }
+    return i - _begin[c];
+}
+
+unsigned char WaveletTree::access(size_t i, size_t& rank) const {
+    unsigned c = 0;
+    for(int level = 0; level < LEVELS; ++level){
+        const RankBitVector& bits = _levels[level];
+        if(bits.get(i)){
+            c = (c << 1) | 1;
+            i = _zeros[level] + bits.rank1(i);
+        } else {
+            c <<= 1;
+            i = bits.rank0(i);
+        }
+    }
+    rank = i - _begin[c];
+    return c;
+}
+
+size_t WaveletTree::memoryUsage() const {
+    size_t bytes = 0;
+    for(int level = 0; level < LEVELS; ++level){
+        bytes += _levels[level].memoryUsage();
+    }
+    return bytes;
+}
+
+
+template< class Index >
+template< class Array >
+FMIndex< Index >::FMIndex(std::string_view text, const Array& suffArray, int sampleRate)
+    : _size(text.size() + 1), _sampleRate(std::max(1, sampleRate)), _first(256, 0), _sampled(_size) {
+
+    //  BWT[row] - символ перед суффиксом строки row
+    std::vector< unsigned char > bwt(_size);
+    for(Index row = 0; row < _size; ++row){
+        Index position = suffArray[row];
+        if(position == 0){
+            _primary = row;
+            bwt[row] = '\0';
+        } else {
+            bwt[row] = text[position - 1];
+        }
+        if(position % _sampleRate == 0){
+            _sampled.set(row);
+            _samples.push_back(position);
+        }
+    }
+    _sampled.buildRank();
+    _bwt = WaveletTree(bwt);
+
+    //  строка 0 - пустой суффикс, символы c идут после всех меньших
+    std::vector< Index > symbols(256, 0);
+    for(size_t i = 0; i < text.size(); ++i){
+        ++symbols[(unsigned char)text[i]];
+    }
+    Index row = 1;
+    for(int c = 0; c < 256; ++c){
+        _first[c] = row;
+        row += symbols[c];
+    }
+}
+
+template< class Index >
+Index FMIndex< Index >::occurrences(unsigned char c, Index i) const {
+    Index result = _bwt.rank(c, i);
+    return (c == '\0' && _primary < i) ? result - 1 : result;
+}
+
+template< class Index >
+Index FMIndex< Index >::previousRow(Index row) const {
+    if(row == _primary){
+        return 0;
+    }
+    size_t rank;
+    unsigned char c = _bwt.access(row, rank);
+    if(c == '\0' && _primary < row){
+        --rank;
+    }
+    return _first[c] + rank;
+}
+
+template< class Index >
+void FMIndex< Index >::search(std::string_view pattern, Index& begin, Index& end) const {
+    //  обратный поиск: строки, начинающиеся с pattern[k..], по символу
+    //  pattern[k - 1] переходят в строки, начинающиеся с pattern[k - 1..]
+    begin = 0;
+    end = _size;
+    for(size_t k = pattern.size(); k > 0 && begin < end; --k){
+        unsigned char c = pattern[k - 1];
+        begin = _first[c] + occurrences(c, begin);
+        end = _first[c] + occurrences(c, end);
+    }
+}
+
+template< class Index >
+Index FMIndex< Index >::count(std::string_view pattern) const {
+    Index begin, end;
+    search(pattern, begin, end);
+    return std::max< Index >(0, end - begin);
+}
+
+template< class Index >
+void FMIndex< Index >::locate(std::string_view pattern, std::vector< Index >& positions) const {
+    Index begin, end;
+    search(pattern, begin, end);
+
+    //  от строки идем влево по тексту, пока не попадем в запомненную позицию.
+    //  позиция 0 всегда запомнена, так что через _primary путь не проходит
+    positions.clear();
+    for(Index row = begin; row < end; ++row){
+        Index current = row;
+        Index steps = 0;
+        while(!_sampled.get(current)){
+            current = previousRow(current);
+            ++steps;
+        }
+        positions.push_back(_samples[_sampled.rank1(current)] + steps);
+    }
+    std::sort(positions.begin(), positions.end());
+}
+
+template< class Index >
+int FMIndex< Index >::sampleRate() const {
+    return _sampleRate;
+}
+
+template< class Index >
+size_t FMIndex< Index >::memoryUsage() const {
+    return _bwt.memoryUsage() + _sampled.memoryUsage() +
+           (_first.size() + _samples.size()) * sizeof(Index);
+}
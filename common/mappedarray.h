@@ -0,0 +1,46 @@
+/*  Массив только для чтения поверх чужой памяти, обычно страниц файла,
+    отображенного через MappedInput: ничего не копирует и не владеет данными.
+    Поддерживает то же чтение, что std::vector (size, operator[]), так что
+    подставляется в шаблоны вместо него для загруженных с диска индексов.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <cstddef>
+
+template< class T >
+class MappedArray
+{
+public:
+    MappedArray() = default;
+    MappedArray(const T* begin, const T* end);
+
+    size_t size() const;
+    const T* data() const;
+    const T& operator[](size_t i) const;
+
+private:
+    const T* _data = nullptr;
+    size_t _size = 0;
+};
+
+
+template< class T >
+MappedArray< T >::MappedArray(const T* begin, const T* end) : _data(begin), _size(end - begin) {}
+
+template< class T >
+size_t MappedArray< T >::size() const {
+    return _size;
+}
+
+template< class T >
+const T* MappedArray< T >::data() const {
+    return _data;
+}
+
+template< class T >
+const T& MappedArray< T >::operator[](size_t i) const {
+    return _data[i];
+}
@@ -0,0 +1,131 @@
+/*  Ввод без копирования:
+    файл (или stdin, если он перенаправлен из обычного файла) отображается в память
+    через mmap, а токены выдаются как std::string_view прямо на отображенные страницы.
+    Если stdin - канал или терминал, он один раз дочитывается в буфер через read().
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedInput
+{
+public:
+    // path == nullptr - читаем stdin
+    explicit MappedInput(const char* path = nullptr);
+    ~MappedInput();
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    // все содержимое входа
+    std::string_view data() const;
+
+    // следующий токен между пробельными символами, пустой в конце входа
+    std::string_view next();
+
+    // следующий токен как целое число
+    long long nextNumber();
+
+private:
+    void readAll(int fd);
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+    size_t _pos = 0;
+
+    // длина отображения, 0 если данные лежат в _fallback
+    size_t _mapped = 0;
+    std::string _fallback;
+};
+
+
+MappedInput::MappedInput(const char* path){
+    int fd = 0;
+    if(path != nullptr){
+        fd = open(path, O_RDONLY);
+        if(fd < 0){
+            throw std::runtime_error(std::string("cannot open ") + path);
+        }
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+        void* pages = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(pages != MAP_FAILED){
+            madvise(pages, info.st_size, MADV_SEQUENTIAL);
+            _data = static_cast< const char* >(pages);
+            _size = info.st_size;
+            _mapped = info.st_size;
+        }
+    }
+
+    if(_mapped == 0){
+        readAll(fd);
+    }
+
+    if(path != nullptr){
+        close(fd);
+    }
+}
+
+MappedInput::~MappedInput(){
+    if(_mapped != 0){
+        munmap(const_cast< char* >(_data), _mapped);
+    }
+}
+
+void MappedInput::readAll(int fd){
+    // запасной путь для каналов: читаем большими блоками без форматирования
+    const size_t BLOCK = 1 << 20;
+    size_t size = 0;
+
+    while(true){
+        _fallback.resize(size + BLOCK);
+        ssize_t got = read(fd, &_fallback[size], BLOCK);
+        if(got <= 0){
+            break;
+        }
+        size += got;
+    }
+
+    _fallback.resize(size);
+    _data = _fallback.data();
+    _size = size;
+}
+
+std::string_view MappedInput::data() const {
+    return std::string_view(_data, _size);
+}
+
+std::string_view MappedInput::next(){
+    while(_pos < _size && static_cast< unsigned char >(_data[_pos]) <= ' '){
+        ++_pos;
+    }
+
+    size_t start = _pos;
+    while(_pos < _size && static_cast< unsigned char >(_data[_pos]) > ' '){
+        ++_pos;
+    }
+
+    return std::string_view(_data + start, _pos - start);
+}
+
+long long MappedInput::nextNumber(){
+    std::string_view token = next();
+
+    long long value = 0;
+    std::from_chars(token.data(), token.data() + token.size(), value);
+    return value;
+}
@@ -0,0 +1,148 @@
+/*  Массив 40-битных чисел, упакованных по 5 байт:
+    индексы суффиксного массива для текстов до 2^40 - 2 байт (около 1 ТБ)
+    занимают 5n байт вместо 8n у std::vector< long long >.
+    Элемент читается и пишется одним невыровненным 8-байтным словом
+    (порядок байт little-endian), запись - через прокси-ссылку. Запись
+    в соседние элементы из разных потоков гонится за одно слово, так что
+    массив заполняется в одном потоке.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+class PackedArray
+{
+public:
+    class Reference;
+
+    explicit PackedArray(size_t size = 0, long long value = 0);
+    // упаковывает числа [begin, end), например массив, прочитанный из файла
+    PackedArray(const long long* begin, const long long* end);
+
+    size_t size() const;
+    void assign(size_t size, long long value);
+    void resize(size_t size, long long value = 0);
+    void swap(PackedArray& other);
+
+    long long operator[](size_t i) const;
+    Reference operator[](size_t i);
+
+    bool operator==(const PackedArray& other) const;
+    bool operator!=(const PackedArray& other) const;
+
+    // самое большое хранимое число; все единицы в 40 битах означают -1
+    static const long long MAX_VALUE = (1ll << 40) - 2;
+
+private:
+    static const int BYTES = 5;
+    static const unsigned long long MASK = (1ull << 40) - 1;
+
+    long long get(size_t i) const;
+    void set(size_t i, long long value);
+
+    // в конце 3 лишних байта, чтобы 8-байтное слово последнего элемента
+    // не выходило за буфер
+    std::vector< unsigned char > _bytes;
+    size_t _size = 0;
+};
+
+
+class PackedArray::Reference
+{
+public:
+    Reference(PackedArray& array, size_t i) : _array(array), _i(i) {}
+
+    operator long long() const { return _array.get(_i); }
+
+    Reference& operator=(long long value){ _array.set(_i, value); return *this; }
+    Reference& operator=(const Reference& other){ return *this = (long long)other; }
+
+    Reference& operator+=(long long value){ return *this = *this + value; }
+    Reference& operator-=(long long value){ return *this = *this - value; }
+
+    // префиксные формы возвращают новое значение, постфиксные - старое
+    long long operator++(){ long long value = *this + 1; *this = value; return value; }
+    long long operator--(){ long long value = *this - 1; *this = value; return value; }
+    long long operator++(int){ long long value = *this; *this = value + 1; return value; }
+    long long operator--(int){ long long value = *this; *this = value - 1; return value; }
+
+private:
+    PackedArray& _array;
+    size_t _i;
+};
+
+
+PackedArray::PackedArray(size_t size, long long value){
+    assign(size, value);
+}
+
+PackedArray::PackedArray(const long long* begin, const long long* end){
+    assign(end - begin, 0);
+    for(size_t i = 0; i < _size; ++i){
+        set(i, begin[i]);
+    }
+}
+
+size_t PackedArray::size() const {
+    return _size;
+}
+
+void PackedArray::assign(size_t size, long long value){
+    _size = size;
+    _bytes.assign(size * BYTES + 3, 0);
+    if(value != 0){
+        for(size_t i = 0; i < size; ++i){
+            set(i, value);
+        }
+    }
+}
+
+void PackedArray::resize(size_t size, long long value){
+    size_t old = _size;
+    _size = size;
+    _bytes.resize(size * BYTES + 3, 0);
+    for(size_t i = old; i < size; ++i){
+        set(i, value);
+    }
+}
+
+void PackedArray::swap(PackedArray& other){
+    _bytes.swap(other._bytes);
+    std::swap(_size, other._size);
+}
+
+long long PackedArray::get(size_t i) const {
+    unsigned long long word;
+    std::memcpy(&word, &_bytes[i * BYTES], sizeof(word));
+    word &= MASK;
+    return (word == MASK) ? -1 : (long long)word;
+}
+
+void PackedArray::set(size_t i, long long value){
+    unsigned long long word;
+    std::memcpy(&word, &_bytes[i * BYTES], sizeof(word));
+    word = (word & ~MASK) | ((unsigned long long)value & MASK);
+    std::memcpy(&_bytes[i * BYTES], &word, sizeof(word));
+}
+
+long long PackedArray::operator[](size_t i) const {
+    return get(i);
+}
+
+PackedArray::Reference PackedArray::operator[](size_t i){
+    return Reference(*this, i);
+}
+
+bool PackedArray::operator==(const PackedArray& other) const {
+    return _size == other._size &&
+           std::memcmp(_bytes.data(), other._bytes.data(), _size * BYTES) == 0;
+}
+
+bool PackedArray::operator!=(const PackedArray& other) const {
+    return !(*this == other);
+}
@@ -0,0 +1,212 @@
+/*  Параллельное построение суффиксного массива удвоением префиксов:
+    в каждой фазе сдвиги, уже упорядоченные по второй половине, устойчиво
+    сортируются по классу первой половины поразрядной сортировкой (LSD),
+    которую потоки делят по кускам массива. Классы новой фазы считаются
+    параллельным префиксным суммированием. Результат совпадает с
+    последовательным удвоением при любом числе потоков.
+    Index - тип индексов: int для строк короче 2^31, long long для длинных.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+template< class Index = int >
+class ParallelDoubling
+{
+public:
+    explicit ParallelDoubling(int threads);
+
+    // perm - порядок циклических сдвигов строки длины size, symbol(i) - ее
+    // i-й символ, меньший 2^symbolBits (по умолчанию байт)
+    template< class Symbol >
+    void build(Index size, Symbol symbol, std::vector< Index >& perm, int symbolBits = 8);
+
+private:
+    // разряд поразрядной сортировки: 2^11 счетчиков на поток помещаются в L1
+    static const int DIGIT_BITS = 11;
+    static const int BUCKETS = 1 << DIGIT_BITS;
+
+    // job(t, begin, end) для кусков [0, size), по одному на поток. разбиение
+    // зависит только от size и t, так что два вызова подряд делят одинаково
+    template< class Job >
+    void parallelFor(Index size, Job job);
+
+    // устойчиво сортирует _values по _keys, ключи меньше 2^bits
+    void radixSort(Index size, int bits);
+
+    // classes[perm[j]] = номер класса, новый класс начинается там,
+    // где differ(perm[j - 1], perm[j]). возвращает число классов
+    template< class Differ >
+    Index assignClasses(const std::vector< Index >& perm, Differ differ, std::vector< Index >& classes);
+
+    int _threads;
+
+    std::vector< Index > _keys;
+    std::vector< Index > _values;
+    std::vector< Index > _spareKeys;
+    std::vector< Index > _spareValues;
+
+    // счетчики разрядов, BUCKETS на поток
+    std::vector< Index > _histogram;
+    std::vector< Index > _chunkSum;
+};
+
+
+template< class Index >
+ParallelDoubling< Index >::ParallelDoubling(int threads) : _threads(std::max(1, threads)) {
+    _histogram.resize(_threads * BUCKETS);
+    _chunkSum.resize(_threads + 1);
+}
+
+template< class Index >
+template< class Job >
+void ParallelDoubling< Index >::parallelFor(Index size, Job job){
+    auto chunk = [&](int t){
+        job(t, (Index)((long long)size * t / _threads), (Index)((long long)size * (t + 1) / _threads));
+    };
+
+    if(_threads == 1){
+        chunk(0);
+        return;
+    }
+
+    std::vector< std::thread > workers;
+    for(int t = 1; t < _threads; ++t){
+        workers.emplace_back(chunk, t);
+    }
+    chunk(0);
+
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+template< class Index >
+void ParallelDoubling< Index >::radixSort(Index size, int bits){
+    for(int shift = 0; shift < bits; shift += DIGIT_BITS){
+        parallelFor(size, [&](int t, Index begin, Index end){
+            Index* count = &_histogram[t * BUCKETS];
+            std::fill(count, count + BUCKETS, 0);
+            for(Index i = begin; i < end; ++i){
+                ++count[(_keys[i] >> shift) & (BUCKETS - 1)];
+            }
+        });
+
+        // разряд d потока t пишется после всех меньших разрядов и после
+        // разряда d предыдущих потоков - так сортировка остается устойчивой
+        Index sum = 0;
+        for(int digit = 0; digit < BUCKETS; ++digit){
+            for(int t = 0; t < _threads; ++t){
+                Index count = _histogram[t * BUCKETS + digit];
+                _histogram[t * BUCKETS + digit] = sum;
+                sum += count;
+            }
+        }
+
+        parallelFor(size, [&](int t, Index begin, Index end){
+            Index* place = &_histogram[t * BUCKETS];
+            for(Index i = begin; i < end; ++i){
+                Index to = place[(_keys[i] >> shift) & (BUCKETS - 1)]++;
+                _spareKeys[to] = _keys[i];
+                _spareValues[to] = _values[i];
+            }
+        });
+
+        _keys.swap(_spareKeys);
+        _values.swap(_spareValues);
+    }
+}
+
+template< class Index >
+template< class Differ >
+Index ParallelDoubling< Index >::assignClasses(const std::vector< Index >& perm, Differ differ, std::vector< Index >& classes){
+    Index size = perm.size();
+
+    // границы классов копятся в _keys, сначала суммы по кускам, потом
+    // каждый поток продолжает счет со своего смещения
+    parallelFor(size, [&](int t, Index begin, Index end){
+        Index sum = 0;
+        for(Index j = begin; j < end; ++j){
+            _keys[j] = (j > 0 && differ(perm[j - 1], perm[j])) ? 1 : 0;
+            sum += _keys[j];
+        }
+        _chunkSum[t + 1] = sum;
+    });
+
+    _chunkSum[0] = 0;
+    for(int t = 0; t < _threads; ++t){
+        _chunkSum[t + 1] += _chunkSum[t];
+    }
+
+    parallelFor(size, [&](int t, Index begin, Index end){
+        Index current = _chunkSum[t];
+        for(Index j = begin; j < end; ++j){
+            current += _keys[j];
+            classes[perm[j]] = current;
+        }
+    });
+
+    return _chunkSum[_threads] + 1;
+}
+
+template< class Index >
+template< class Symbol >
+void ParallelDoubling< Index >::build(Index size, Symbol symbol, std::vector< Index >& perm, int symbolBits){
+    _keys.resize(size);
+    _values.resize(size);
+    _spareKeys.resize(size);
+    _spareValues.resize(size);
+
+    // нулевая фаза: сдвиги по первому символу
+    parallelFor(size, [&](int /*t*/, Index begin, Index end){
+        for(Index i = begin; i < end; ++i){
+            _keys[i] = symbol(i);
+            _values[i] = i;
+        }
+    });
+    radixSort(size, symbolBits);
+
+    perm.swap(_values);
+    _values.resize(size);
+
+    std::vector< Index > classes(size);
+    std::vector< Index > nextClasses(size);
+    Index numEqClasses = assignClasses(perm, [&](Index a, Index b){
+        return symbol(a) != symbol(b);
+    }, classes);
+
+    for(Index shift = 1; shift < size && numEqClasses < size; shift <<= 1){
+        // сдвиги perm[j] - shift уже упорядочены по второй половине,
+        // остается устойчиво отсортировать их по классу первой
+        parallelFor(size, [&](int /*t*/, Index begin, Index end){
+            for(Index j = begin; j < end; ++j){
+                Index from = perm[j] - shift;
+                from += (from < 0) ? size : 0;
+                _values[j] = from;
+                _keys[j] = classes[from];
+            }
+        });
+
+        int bits = 0;
+        while((1ll << bits) < numEqClasses){
+            ++bits;
+        }
+        radixSort(size, bits);
+        perm.swap(_values);
+
+        numEqClasses = assignClasses(perm, [&](Index a, Index b){
+            Index secondA = a + shift;
+            Index secondB = b + shift;
+            secondA -= (secondA >= size) ? size : 0;
+            secondB -= (secondB >= size) ? size : 0;
+            return classes[a] != classes[b] || classes[secondA] != classes[secondB];
+        }, nextClasses);
+
+        classes.swap(nextClasses);
+    }
+}
@@ -0,0 +1,80 @@
+/*  Битовый вектор с rank за O(1): на каждые 512 бит (8 слов) хранится
+    число единиц до них, внутри блока считается popcount не больше 8 слов.
+    Накладные расходы - 1/8 бита на бит.
+
+    developed by Crashdown
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class RankBitVector
+{
+public:
+    explicit RankBitVector(size_t size = 0);
+
+    void set(size_t i);
+    bool get(size_t i) const;
+
+    // пересчитывает счетчики блоков, вызывается после всех set()
+    void buildRank();
+
+    // число единиц в [0, i)
+    size_t rank1(size_t i) const;
+    size_t rank0(size_t i) const;
+
+    size_t memoryUsage() const;
+
+private:
+    static const int BLOCK_WORDS = 8;
+
+    std::vector< unsigned long long > _words;
+    std::vector< unsigned long long > _blockRank;
+};
+
+
+RankBitVector::RankBitVector(size_t size) : _words((size + 63) / 64, 0) {}
+
+void RankBitVector::set(size_t i){
+    _words[i / 64] |= 1ull << (i % 64);
+}
+
+bool RankBitVector::get(size_t i) const {
+    return (_words[i / 64] >> (i % 64)) & 1;
+}
+
+void RankBitVector::buildRank(){
+    _blockRank.assign(_words.size() / BLOCK_WORDS + 1, 0);
+    unsigned long long ones = 0;
+    for(size_t w = 0; w < _words.size(); ++w){
+        if(w % BLOCK_WORDS == 0){
+            _blockRank[w / BLOCK_WORDS] = ones;
+        }
+        ones += __builtin_popcountll(_words[w]);
+    }
+    if(_words.size() % BLOCK_WORDS == 0){
+        _blockRank.back() = ones;
+    }
+}
+
+size_t RankBitVector::rank1(size_t i) const {
+    size_t word = i / 64;
+    size_t result = _blockRank[word / BLOCK_WORDS];
+    for(size_t w = word - word % BLOCK_WORDS; w < word; ++w){
+        result += __builtin_popcountll(_words[w]);
+    }
+    if(i % 64 != 0){
+        result += __builtin_popcountll(_words[word] << (64 - i % 64));
+    }
+    return result;
+}
+
+size_t RankBitVector::rank0(size_t i) const {
+    return i - rank1(i);
+}
+
+size_t RankBitVector::memoryUsage() const {
+    return (_words.size() + _blockRank.size()) * sizeof(unsigned long long);
+}
@@ -0,0 +1,74 @@
+// Замер вывода 10^7 позиций вхождений в /dev/null: std::cout против OutputWriter.
+//     g++ -std=c++17 -O2 bench.cpp -o bench && ./bench
+#include "../benchmark.h"
+#include "../fastoutput.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include <fcntl.h>
+
+int main()
+{
+    const int COUNT = 10000000;
+
+    // возрастающие смещения, как у результата поиска
+    std::mt19937 rng(179);
+    std::vector< int > offsets(COUNT);
+    int current = 0;
+    for(int i = 0; i < COUNT; ++i){
+        current += 1 + rng() % 200;
+        offsets[i] = current;
+    }
+
+    {
+        std::ofstream null("/dev/null");
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < COUNT; ++i){
+            null << offsets[i] << " ";
+        }
+        null.flush();
+        std::cout << "std::ostream: " << seconds(start) << " s\n";
+    }
+
+    {
+        int fd = open("/dev/null", O_WRONLY);
+        auto start = std::chrono::steady_clock::now();
+        {
+            OutputWriter output(fd);
+            for(int i = 0; i < COUNT; ++i){
+                output.write(offsets[i]);
+                output.write(' ');
+            }
+        }
+        std::cout << "OutputWriter: " << seconds(start) << " s\n";
+        close(fd);
+    }
+
+    // проверка, что текст совпадает с printf
+    {
+        char path[] = "/tmp/outputXXXXXX";
+        int fd = mkstemp(path);
+        {
+            OutputWriter output(fd, 64);
+            long long values[] = {0, 7, 10, 99, 100, 12345, -1, -100, 2147483647, -9223372036854775807ll - 1};
+            for(long long value : values){
+                output.write(value);
+                output.write(' ');
+            }
+        }
+        close(fd);
+
+        std::ifstream in(path);
+        std::string written((std::istreambuf_iterator< char >(in)), std::istreambuf_iterator< char >());
+        std::remove(path);
+
+        std::string expected = "0 7 10 99 100 12345 -1 -100 2147483647 -9223372036854775808 ";
+        std::cout << (written == expected ? "format: OK\n" : "format: MISMATCH\n");
+    }
+
+    return 0;
+}
@@ -10,26 +10,95 @@
     developed by Crashdown
 
 */
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../../common/fastoutput.h"
+#include "../../common/mappedinput.h"
+
 class KMP
 {
 public:
-    KMP(std::string& pattern, std::string& text) : _pattern(pattern), _text(text) {
+    // шаблон и текст не копируются: достаточно, чтобы они жили дольше объекта
+    KMP(std::string_view pattern, std::string_view text) : _pattern(pattern), _text(text) {
+        prefixBuild();
+    }
+
+    // потоковый режим: текст целиком не хранится, а подается кусками через feed()
+    explicit KMP(std::string_view pattern) : _pattern(pattern) {
         prefixBuild();
     }
 
     void prefixBuild();
 
+    // разворачивает префикс-функцию в полную таблицу переходов (p + 1) x σ,
+    // где σ - число различных символов шаблона плюс класс "остальные".
+    // вызывается из prefixBuild(), если таблица помещается в L2
+    void buildAutomaton();
+
+    // принудительно включает или выключает табличный режим
+    void useAutomaton(bool enable);
+
     void find(std::vector< int >& result);
 
+    // параллельный поиск: текст делится на threads отрезков, каждый поток
+    // прогоняет автомат со своей копией состояния. состояние _last не меняется
+    void findParallel(std::vector< int >& result, int threads) const;
+
+    // поиск с векторным префильтром: сравниваются первый и последний символы
+    // шаблона сразу на 32 (AVX2) или 16 (SSE2) позициях, автомат запускается
+    // только на окнах кандидатов. результат тот же, что у find() с нуля
+    void findPrefiltered(std::vector< int >& result) const;
+
+    // обрабатывает очередной кусок текста, в result пишутся абсолютные позиции
+    // вхождений относительно начала всего потока. между вызовами хранятся
+    // только _buffer, _last и число уже обработанных символов
+    void feed(const char* chunk, size_t size, std::vector< long long >& result);
+
+    // сбрасывает состояние автомата для нового потока
+    void reset();
+
 private:
+    friend class MultiKMP;
+
+    // один переход автомата префикс-функции
+    int step(int pos, char chr) const;
+
+    // прогоняет автомат по data начиная с состояния pos и вызывает
+    // onMatch(i) для каждого i, на котором заканчивается вхождение.
+    // режим выбирается один раз, а не на каждом символе
+    template< class Callback >
+    int scan(const char* data, size_t size, int pos, Callback onMatch) const;
+
+    // ищет вхождения, заканчивающиеся в [begin, end), начиная автомат с нуля
+    void findSegment(int begin, int end, std::vector< int >& result) const;
+
+    // размер L2, под который подбирается табличный режим
+    static const int L2_CACHE_SIZE = 1 << 18;
+
     std::vector< int > _buffer;
+    // таблица переходов и отображение байта в класс символа
+    std::vector< int > _automaton;
+    std::vector< unsigned char > _alphabet;
+    int _sigma = 0;
+
     int _last = 0;
+    long long _processed = 0;
 
-    std::string& _pattern;
-    std::string& _text;
+    std::string_view _pattern;
+    std::string_view _text;
 
 };
 
@@ -47,44 +116,337 @@ void KMP::prefixBuild(){
         }
         _buffer[i] = pos;
     }
+
+    std::vector< bool > used(256, false);
+    for(int i = 0; i < _pattern.size(); ++i){
+        used[(unsigned char)_pattern[i]] = true;
+    }
+    int sigma = 1 + std::count(used.begin(), used.end(), true);
+
+    if((long long)(_pattern.size() + 1) * sigma * sizeof(int) <= L2_CACHE_SIZE){
+        buildAutomaton();
+    }
+}
+
+void KMP::buildAutomaton(){
+    // класс 0 - символы, которых нет в шаблоне: из любого состояния по ним
+    // переходим в 0
+    _alphabet.assign(256, 0);
+    std::vector< unsigned char > chars(1, 0);
+    for(int i = 0; i < _pattern.size(); ++i){
+        unsigned char chr = _pattern[i];
+        if(_alphabet[chr] == 0){
+            _alphabet[chr] = chars.size();
+            chars.push_back(chr);
+        }
+    }
+    _sigma = chars.size();
+
+    int p = _pattern.size();
+    _automaton.assign((p + 1) * _sigma, 0);
+
+    // строка состояния s - это копия строки состояния по ссылке префикс-функции
+    // (она меньше s и уже достроена) с переходом s -> s + 1 по _pattern[s]
+    _automaton[_alphabet[(unsigned char)_pattern[0]]] = 1;
+
+    for(int s = 1; s <= p; ++s){
+        int link = _buffer[s - 1];
+        std::copy(_automaton.begin() + link * _sigma, _automaton.begin() + (link + 1) * _sigma,
+                  _automaton.begin() + s * _sigma);
+
+        if(s < p){
+            _automaton[s * _sigma + _alphabet[(unsigned char)_pattern[s]]] = s + 1;
+        }
+    }
+}
+
+void KMP::useAutomaton(bool enable){
+    if(!enable){
+        _automaton.clear();
+        _sigma = 0;
+    } else if(_automaton.empty()){
+        buildAutomaton();
+    }
+}
+
+int KMP::step(int pos, char chr) const {
+    // после полного совпадения сразу откатываемся по префикс-функции,
+    // иначе _pattern[pos] указывает за конец шаблона
+    if(pos == _pattern.size()){
+        pos = _buffer[pos - 1];
+    }
+
+    while(pos > 0 && _pattern[pos] != chr){
+        pos = _buffer[pos - 1];
+    }
+
+    if(_pattern[pos] == chr){
+        ++pos;
+    }
+
+    return pos;
+}
+
+template< class Callback >
+int KMP::scan(const char* data, size_t size, int pos, Callback onMatch) const {
+    int p = _pattern.size();
+
+    if(!_automaton.empty()){
+        const int* table = _automaton.data();
+        const unsigned char* alphabet = _alphabet.data();
+
+        for(size_t i = 0; i < size; ++i){
+            pos = table[pos * _sigma + alphabet[(unsigned char)data[i]]];
+            if(pos == p){
+                onMatch(i);
+            }
+        }
+        return pos;
+    }
+
+    for(size_t i = 0; i < size; ++i){
+        pos = step(pos, data[i]);
+        if(pos == p){
+            onMatch(i);
+        }
+    }
+    return pos;
 }
 
 void KMP::find(std::vector< int >& result){
+    int p = _pattern.size();
 
-    for(int i = 0; i < _text.size(); ++i){
-        int pos = _last;
+    _last = scan(_text.data(), _text.size(), _last, [&](size_t i){
+        result.push_back(i + 1 - p);
+    });
+}
 
-        while(pos > 0 && _pattern[pos] != _text[i]){
-            pos = _buffer[pos - 1];
+void KMP::findSegment(int begin, int end, std::vector< int >& result) const {
+    // отрезки перекрываются на p - 1 символ: вхождение, заканчивающееся в
+    // [begin, end), целиком лежит в [begin - p + 1, end)
+    int p = _pattern.size();
+    int start = std::max(0, begin - p + 1);
+
+    scan(_text.data() + start, end - start, 0, [&](size_t i){
+        if(start + (int)i >= begin){
+            result.push_back(start + i + 1 - p);
         }
+    });
+}
 
-        if(_pattern[pos] == _text[i]){
-            ++pos;
+void KMP::findParallel(std::vector< int >& result, int threads) const {
+    int n = _text.size();
+    threads = std::max(1, std::min(threads, n));
+
+    // каждое вхождение заканчивается ровно в одном отрезке, поэтому
+    // склейка результатов по порядку отрезков отсортирована и без повторов
+    std::vector< std::vector< int > > parts(threads);
+    std::vector< std::thread > workers;
+
+    for(int t = 0; t < threads; ++t){
+        int begin = (long long)n * t / threads;
+        int end = (long long)n * (t + 1) / threads;
+        workers.emplace_back(&KMP::findSegment, this, begin, end, std::ref(parts[t]));
+    }
+
+    for(int t = 0; t < threads; ++t){
+        workers[t].join();
+        result.insert(result.end(), parts[t].begin(), parts[t].end());
+    }
+}
+
+void KMP::findPrefiltered(std::vector< int >& result) const {
+    int n = _text.size();
+    int p = _pattern.size();
+    if(p > n){
+        return;
+    }
+
+    const char* text = _text.data();
+    const char first = _pattern[0];
+    const char last = _pattern[p - 1];
+
+    // автомат уже прогнан по [.., scanned) и находится в состоянии pos.
+    // если кандидат начинается правее scanned, между ними нет начал вхождений
+    // и автомат можно перезапустить с нуля. каждый символ читается не больше
+    // одного раза, так что время остается линейным
+    int pos = 0;
+    int scanned = 0;
+
+    auto candidate = [&](int start){
+        if(start > scanned){
+            pos = 0;
+            scanned = start;
+        }
+        int end = start + p;
+        if(end <= scanned){
+            return;
         }
 
-        if(pos == _pattern.size()){
-            result.push_back(i + 1 - _pattern.size());
+        int offset = scanned;
+        pos = scan(text + offset, end - offset, pos, [&](size_t i){
+            result.push_back(offset + i + 1 - p);
+        });
+        scanned = end;
+    };
+
+    int i = 0;
+    int last_start = n - p;
+
+#if defined(__AVX2__)
+    const __m256i firstVec = _mm256_set1_epi8(first);
+    const __m256i lastVec = _mm256_set1_epi8(last);
+
+    for(; i + 32 <= last_start + 1; i += 32){
+        __m256i head = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i tail = _mm256_loadu_si256((const __m256i*)(text + i + p - 1));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, firstVec),
+                                                              _mm256_cmpeq_epi8(tail, lastVec)));
+        while(mask != 0){
+            candidate(i + __builtin_ctz(mask));
+            mask &= mask - 1;
         }
+    }
+#elif defined(__SSE2__)
+    const __m128i firstVec = _mm_set1_epi8(first);
+    const __m128i lastVec = _mm_set1_epi8(last);
+
+    for(; i + 16 <= last_start + 1; i += 16){
+        __m128i head = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(text + i + p - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, firstVec),
+                                                        _mm_cmpeq_epi8(tail, lastVec)));
+        while(mask != 0){
+            candidate(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for(; i <= last_start; ++i){
+        if(text[i] == first && text[i + p - 1] == last){
+            candidate(i);
+        }
+    }
+}
 
-        _last = pos;
+void KMP::feed(const char* chunk, size_t size, std::vector< long long >& result){
+    int p = _pattern.size();
+
+    _last = scan(chunk, size, _last, [&](size_t i){
+        result.push_back(_processed + i + 1 - p);
+    });
+
+    _processed += size;
+}
+
+void KMP::reset(){
+    _last = 0;
+    _processed = 0;
+}
+
+
+// поиск многих шаблонов за один проход по тексту: текст идет блоками размера
+// BLOCK_SIZE, и каждый блок, пока он лежит в кэше, прогоняется через автоматы
+// всех шаблонов по очереди
+class MultiKMP
+{
+public:
+    MultiKMP(const std::vector< std::string_view >& patterns, std::string_view text);
+
+    // пары (номер шаблона, позиция вхождения). пары идут по блокам текста,
+    // порядок внутри блока не гарантируется
+    void find(std::vector< std::pair< int, int > >& result) const;
+
+private:
+    static constexpr int BLOCK_SIZE = 1 << 15;
+    static constexpr int GROUP = 8;
+
+    std::vector< KMP > _searchers;
+    std::string_view _text;
+};
+
+MultiKMP::MultiKMP(const std::vector< std::string_view >& patterns, std::string_view text) : _text(text) {
+    _searchers.reserve(patterns.size());
+    for(int i = 0; i < patterns.size(); ++i){
+        _searchers.emplace_back(patterns[i]);
     }
 }
 
+void MultiKMP::find(std::vector< std::pair< int, int > >& result) const {
+    // состояния автоматов переходят из блока в блок
+    std::vector< int > states(_searchers.size(), 0);
+
+    for(int block = 0; block < _text.size(); block += BLOCK_SIZE){
+        int size = std::min< int >(BLOCK_SIZE, _text.size() - block);
+        const unsigned char* data = (const unsigned char*)_text.data() + block;
+
+        int k = 0;
+        // табличные автоматы идут группами по GROUP: независимые цепочки
+        // загрузок из таблиц перекрываются, а не ждут друг друга
+        for(; k + GROUP <= _searchers.size(); k += GROUP){
+            bool tables = true;
+            for(int g = 0; g < GROUP; ++g){
+                tables = tables && !_searchers[k + g]._automaton.empty();
+            }
+            if(!tables){
+                break;
+            }
+
+            const int* table[GROUP];
+            const unsigned char* alphabet[GROUP];
+            int sigma[GROUP];
+            int p[GROUP];
+            int pos[GROUP];
+            for(int g = 0; g < GROUP; ++g){
+                table[g] = _searchers[k + g]._automaton.data();
+                alphabet[g] = _searchers[k + g]._alphabet.data();
+                sigma[g] = _searchers[k + g]._sigma;
+                p[g] = _searchers[k + g]._pattern.size();
+                pos[g] = states[k + g];
+            }
+
+            for(int i = 0; i < size; ++i){
+                for(int g = 0; g < GROUP; ++g){
+                    pos[g] = table[g][pos[g] * sigma[g] + alphabet[g][data[i]]];
+                    if(pos[g] == p[g]){
+                        result.emplace_back(k + g, block + i + 1 - p[g]);
+                    }
+                }
+            }
+
+            for(int g = 0; g < GROUP; ++g){
+                states[k + g] = pos[g];
+            }
+        }
+
+        for(; k < _searchers.size(); ++k){
+            int p = _searchers[k]._pattern.size();
+
+            states[k] = _searchers[k].scan(_text.data() + block, size, states[k], [&](size_t i){
+                result.emplace_back(k, block + i + 1 - p);
+            });
+        }
+    }
+}
 
-int main() {
+int main(int argc, char** argv) {
 
-    std::string pattern;
-    std::string text;
+    // вход отображается в память, шаблон и текст - окна на его страницы
+    MappedInput input(argc > 1 ? argv[1] : nullptr);
 
-    std::cin >> pattern >> text;
+    std::string_view pattern = input.next();
+    std::string_view text = input.next();
 
     KMP kmp(pattern, text);
     
     std::vector< int > result;    
     kmp.find(result);
 
+    OutputWriter output;
     for(int i = 0; i < result.size(); ++i){
-        std::cout << result[i] << " ";
+        output.write(result[i]);
+        output.write(' ');
     }
 
     return 0;
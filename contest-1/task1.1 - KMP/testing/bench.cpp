@@ -0,0 +1,135 @@
+// Замеры KMP на случайном тексте.
+//     g++ -std=c++17 -O2 [-mavx2] -pthread bench.cpp -o bench && ./bench [размер текста в МБ] [макс. потоков]
+#define main solution_main
+#include "../task1.1.cpp"
+#undef main
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#include "../../../common/benchmark.h"
+
+int main(int argc, char** argv)
+{
+    int megabytes = (argc > 1) ? std::atoi(argv[1]) : 300;
+    int maxThreads = (argc > 2) ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    maxThreads = std::max(1, maxThreads);
+
+    std::mt19937 rng(179);
+    std::string text(megabytes * (1 << 20), 'a');
+    for(int i = 0; i < text.size(); ++i){
+        text[i] = 'a' + rng() % 2;
+    }
+    std::string pattern = "abaabbab";
+
+    std::vector< int > expected;
+    auto start = std::chrono::steady_clock::now();
+    KMP(pattern, text).find(expected);
+    double base = seconds(start);
+    std::cout << "find():          " << base << " s, " << expected.size() << " matches\n";
+
+    KMP kmp(pattern, text);
+    for(int threads = 1; threads <= maxThreads; threads *= 2){
+        std::vector< int > result;
+        start = std::chrono::steady_clock::now();
+        kmp.findParallel(result, threads);
+        double time = seconds(start);
+
+        std::cout << "findParallel(" << threads << "): " << time << " s, speedup "
+                  << base / time << (result == expected ? "" : "  MISMATCH") << "\n";
+    }
+
+    // потоковый режим: тот же текст кусками случайной длины, короткими и
+    // длинными, так что вхождения часто пересекают границы кусков
+    {
+        KMP stream(pattern);
+        std::vector< long long > result;
+        start = std::chrono::steady_clock::now();
+        for(size_t offset = 0; offset < text.size(); ){
+            size_t size = (rng() % 2) ? 1 + rng() % 16 : 1 + rng() % (1 << 16);
+            size = std::min(size, text.size() - offset);
+            stream.feed(text.data() + offset, size, result);
+            offset += size;
+        }
+        double time = seconds(start);
+
+        std::cout << "feed() by chunks: " << time << " s"
+                  << (result == std::vector< long long >(expected.begin(), expected.end()) ? "" : "  MISMATCH") << "\n";
+    }
+
+    // периодический худший случай для цепочки ссылок: шаблон a..ab,
+    // в тексте каждый c откатывает автомат через все p - 1 состояний
+    std::string periodic(text.size(), 'a');
+    for(int i = 63; i < periodic.size(); i += 64){
+        periodic[i] = 'c';
+    }
+    std::string worst = std::string(63, 'a') + "b";
+
+    for(int automaton = 0; automaton < 2; ++automaton){
+        KMP search(worst, periodic);
+        search.useAutomaton(automaton);
+
+        std::vector< int > result;
+        start = std::chrono::steady_clock::now();
+        search.find(result);
+        std::cout << (automaton ? "table, periodic:      " : "prefix-fun, periodic: ")
+                  << seconds(start) << " s\n";
+
+        KMP random(pattern, text);
+        random.useAutomaton(automaton);
+
+        result.clear();
+        start = std::chrono::steady_clock::now();
+        random.find(result);
+        std::cout << (automaton ? "table, random:        " : "prefix-fun, random:   ")
+                  << seconds(start) << " s\n";
+    }
+
+    // пропускная способность префильтра на тексте над a-z
+    std::string letters(text.size(), 'a');
+    for(int i = 0; i < letters.size(); ++i){
+        letters[i] = 'a' + rng() % 26;
+    }
+    std::string word = "kmpsearch";
+    double gigabytes = letters.size() / 1e9;
+
+    std::vector< int > plain;
+    start = std::chrono::steady_clock::now();
+    KMP(word, letters).find(plain);
+    std::cout << "find(), a-z:            " << gigabytes / seconds(start) << " GB/s\n";
+
+    std::vector< int > filtered;
+    start = std::chrono::steady_clock::now();
+    KMP(word, letters).findPrefiltered(filtered);
+    std::cout << "findPrefiltered(), a-z: " << gigabytes / seconds(start) << " GB/s"
+              << (filtered == plain ? "" : "  MISMATCH") << "\n";
+
+    // много шаблонов: один проход MultiKMP против отдельного find() на каждый
+    const int PATTERNS = 1000;
+    std::vector< std::string > words(PATTERNS);
+    for(int k = 0; k < PATTERNS; ++k){
+        for(int j = 0; j < 6; ++j){
+            words[k] += 'a' + rng() % 26;
+        }
+    }
+    std::string_view sample(letters.data(), std::min< size_t >(letters.size(), 2 << 20));
+
+    int separateMatches = 0;
+    start = std::chrono::steady_clock::now();
+    for(int k = 0; k < PATTERNS; ++k){
+        std::vector< int > result;
+        KMP(words[k], sample).find(result);
+        separateMatches += result.size();
+    }
+    std::cout << PATTERNS << " x find():  " << seconds(start) << " s\n";
+
+    std::vector< std::string_view > views(words.begin(), words.end());
+    std::vector< std::pair< int, int > > pairs;
+    start = std::chrono::steady_clock::now();
+    MultiKMP(views, sample).find(pairs);
+    std::cout << "MultiKMP::find(): " << seconds(start) << " s"
+              << (pairs.size() == separateMatches ? "" : "  MISMATCH") << "\n";
+
+    return 0;
+}
@@ -7,85 +7,243 @@
     Время работы - O(n + m + Z), где Z - общее -число вхождений подстрок шаблона 
     “между вопросиками” в исходном тексте. m ≤ 5000, n ≤ 2000000.
 
+    Если Z велико, вместо автомата используются свертки (NTT) за O(n log m).
+
     developed by Crashdown
 
 */
 #pragma GCC optimize("Ofast,unroll-all-loops")
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "../../common/fastoutput.h"
+#include "../../common/mappedinput.h"
+
 
 class AchoKorasic{
 public:
 
-    AchoKorasic(std::string& mask);
+    // маска не копируется и должна жить дольше автомата
+    AchoKorasic(std::string_view mask);
 
-    // функция для поиска ответа на задачу
-    void find(std::string& text, std::vector< int >& ans);
+    // сохраняет построенный автомат в файл: заголовок с версией и размерами,
+    // затем все таблицы подряд, без указателей, с выравниванием на 8 байт
+    void save(const char* path) const;
 
-private:
+    // открывает файл, записанный save(), через mmap: таблицы не копируются
+    // и не перестраиваются, а процессы с одним файлом делят его страницы.
+    // бросает std::runtime_error, если файл не того формата или версии
+    static AchoKorasic load(const char* path);
 
-    // функции для построения бора
-    void subMasksInit();
-    void addSubMask(int start, int end, int pattern);
+    // способ поиска: автомат Ахо-Корасик за O(n + m + Z) или
+    // свертки за O(n log m), которые не зависят от вида маски
+    enum class Engine { Auto, Automaton, Convolution };
 
-    // парные рекурсивные функции для построения суфф ссфлок и терминальных переходов
-    int buildSuffLink(int vertex);
-    int buildTerminateLink(int vertex, char chr);
+    // функция для поиска ответа на задачу. автомат после построения
+    // не меняется, так что find можно вызывать из нескольких потоков
+    void find(std::string_view text, std::vector< int >& ans, Engine engine = Engine::Auto) const;
 
-    // структура с данными вершины
-    struct Point;
+    // оценка Z по частотам символов текста, как если бы они шли независимо
+    double estimateOccurrences(std::string_view text) const;
 
-    std::string& _mask;
-    // бор
-    std::vector< Point > _buffer;
-    // позиции подмасок без ?
-    std::vector< std::pair<int, int > > _subMasks;
-};
+    // выбор способа поиска по оценке Z
+    Engine chooseEngine(std::string_view text) const;
 
-struct AchoKorasic::Point{
-    char chr;
-    bool isTerminal;
+    // параллельный поиск: текст режется на threads кусков, каждый поток ведет
+    // свой курсор по общему автомату. результат тот же, что у find()
+    void findParallel(std::string_view text, std::vector< int >& ans, int threads) const;
 
-    int parent;
-    int suffLink;
+    // поиск во многих коротких текстах сразу: ans[r] - вхождения в texts[r].
+    // BATCH_LANES текстов идут по автомату в одном цикле, чтобы промахи кэша
+    // на переходах разных текстов перекрывались, а не ждали друг друга
+    void findBatch(const std::vector< std::string_view >& texts, std::vector< std::vector< int > >& ans) const;
 
-    std::vector< int > children;
-    std::vector< int > jumps;
-    std::vector< int > patterns;
+    // сколько байт занимает бор
+    size_t memoryUsage() const;
 
-    Point(int parent_, char chr_) : chr(chr_), parent(parent_){
-        suffLink = -1;
-        init();
-    }
+    // число вершин бора
+    int nodesCount() const;
 
-    Point(int parent_, char chr_, int suffLink_) : chr(chr_), parent(parent_){
-        suffLink = suffLink_;
-        init();
-    }
+    // потоковый поиск по одному автомату: текст подается кусками,
+    // памяти O(m) независимо от длины текста
+    class Stream;
 
-    void init(){
-        isTerminal = false;
-        children.resize(26, -1);
-        jumps.resize(26, -1);
-    }
+private:
+
+    // пустой автомат, который заполняет load()
+    AchoKorasic() = default;
+
+    // алфавит - все байты
+    static const int ALPHABET = 256;
+    // вершины с таким числом детей и больше получают плотную строку переходов
+    static const int DENSE_CHILDREN = 16;
+    // сколько всего плотных строк (по 1 КБ) можно завести
+    static const int DENSE_LIMIT = 1024;
+    // сколько текстов findBatch ведет одновременно
+    static const int BATCH_LANES = 8;
+
+    // ребра бора на время построения: списки пар (символ, ребенок)
+    typedef std::vector< std::vector< std::pair< unsigned char, int > > > Edges;
+
+    // функции для построения бора
+    void subMasksInit();
+    int addNode(Edges& edges);
+    void addSubMask(int start, int end, int pattern, Edges& edges, std::vector< std::pair< int, int > >& terminals);
+    void buildPatternLists(const std::vector< std::pair< int, int > >& terminals);
+    // переводит списки ребер в битовые маски и сплошной массив детей
+    void packChildren(Edges& edges);
+
+    // обход бора в ширину: считает все суффиксные ссылки и строит плотные
+    // строки переходов для корня, его детей и вершин с многими детьми
+    void buildLinks();
+
+    // все таблицы бора только для чтения. при построении указатели смотрят
+    // в векторы ниже, после load() - прямо в отображенный файл
+    struct Tables{
+        const char* mask = nullptr;
+        const unsigned long long* childMask = nullptr;
+        const int* childStart = nullptr;
+        const int* children = nullptr;
+        const int* denseRow = nullptr;
+        const int* dense = nullptr;
+        const int* suffLink = nullptr;
+        const int* terminalLink = nullptr;
+        const int* patternsStart = nullptr;
+        const int* patterns = nullptr;
+        const int* subMaskStart = nullptr;
+        const int* subMaskEnd = nullptr;
+
+        long long maskSize = 0;
+        int nodes = 0;
+        int childrenCount = 0;
+        int denseRows = 0;
+        int patternsCount = 0;
+        int subMasks = 0;
+    };
+
+    // заголовок файла; числа пишутся в порядке байт машины, поэтому
+    // BYTE_ORDER_MARK отсекает файлы, записанные на другой архитектуре
+    struct FileHeader{
+        char magic[8];
+        unsigned version;
+        unsigned byteOrder;
+        long long maskSize;
+        int nodes;
+        int childrenCount;
+        int denseRows;
+        int patternsCount;
+        int subMasks;
+        int alphabet;
+    };
+
+    static const unsigned FILE_VERSION = 1;
+    static const unsigned BYTE_ORDER_MARK = 0x01020304;
+    static constexpr char FILE_MAGIC[8] = "ACHOKOR";
+
+    // вызывает visit(указатель, число элементов) для каждой таблицы в том
+    // порядке, в котором они лежат в файле. по нему же считается memoryUsage
+    template< class Visitor >
+    static void forEachTable(Tables& tables, Visitor visit);
+
+    // направляет _tables на векторы; вызывается, когда векторы перестали расти
+    void refreshTables();
+
+    bool isTerminal(int vertex) const;
+
+    // ребенок вершины по символу через ранг в битовой маске, -1 если нет
+    int child(int vertex, unsigned char chr) const;
+
+    // переход автомата: плотная строка, если она есть, иначе ребро бора
+    // или переход из суффиксной ссылки. корень плотный, так что цикл конечен
+    int next(int vertex, unsigned char chr) const;
+
+    void findAutomaton(std::string_view text, std::vector< int >& ans) const;
+
+    // для маски p с весами w (0 на месте ?) и текста t позиция s подходит,
+    // если sum w_j (p_j - t_{s+j})^2 = 0. сумма раскладывается на константу
+    // и две свертки: с w p и t, с w и t^2. текст режется на блоки, каждый
+    // блок - три NTT размера N ~ 4m
+    void findConvolution(std::string_view text, std::vector< int >& ans) const;
+
+    // NTT по модулю 998244353. символы маски кодируются числами 1..k, прочие
+    // символы текста - нулем, так что суммы не больше k^2 m и должны быть < MOD
+    static const unsigned MOD = 998244353;
+    static const unsigned ROOT = 3;
+
+    static unsigned power(unsigned long long base, unsigned long long exp);
+    static void ntt(std::vector< unsigned >& a, bool invert);
+
+    // переход автомата по chr; для каждой подмаски, которая заканчивается
+    // на этом символе, вызывает vote(конец подмаски в маске)
+    template< class Vote >
+    int step(int vertex, char chr, Vote vote) const;
+
+    std::string_view _mask;
+
+    // коды символов для сверток: символы маски по возрастанию получают 1..k,
+    // остальные 0. возвращает k
+    int convolutionCodes(std::vector< unsigned >& code) const;
+
+    // поддерживается ли маска сверточным движком (k^2 m < MOD)
+    bool convolutionFits() const;
+
+    // бор хранится по полям: вершина v - это индекс во всех массивах.
+    // дети v отмечены в битовой маске _childMask[4v .. 4v + 3] и лежат подряд
+    // с _children[_childStart[v]] по возрастанию символа
+    std::vector< unsigned long long > _childMask;
+    std::vector< int > _childStart;
+    std::vector< int > _children;
+
+    // у плотных вершин есть полная строка переходов автомата
+    // _dense[_denseRow[v] * ALPHABET ..], у разреженных _denseRow[v] = -1
+    std::vector< int > _denseRow;
+    std::vector< int > _dense;
+
+    std::vector< int > _suffLink;
+    // ближайшая терминальная вершина на цепочке суффиксных ссылок (не считая
+    // самой вершины), 0 если такой нет
+    std::vector< int > _terminalLink;
+
+    // номера подмасок, заканчивающихся в вершине v:
+    // _patterns[_patternsStart[v] .. _patternsStart[v + 1])
+    std::vector< int > _patternsStart;
+    std::vector< int > _patterns;
+
+    // позиции подмасок без ?: подмаска i - это _mask[_subMaskStart[i] .. _subMaskEnd[i]]
+    std::vector< int > _subMaskStart;
+    std::vector< int > _subMaskEnd;
+
+    Tables _tables;
+
+    // отображение файла, из которого загружен автомат; у построенного пусто
+    std::unique_ptr< MappedInput > _file;
 };
 
 void AchoKorasic::subMasksInit(){
     // функция режет исходную маску на подмаски без символов ?
     int current_start = 0;
 
-    while(_mask[current_start] == '?' && current_start < _mask.size()){
+    while(current_start < _mask.size() && _mask[current_start] == '?'){
         current_start++;
     }
 
     int i = current_start + 1;
     while(i < _mask.size()){
         if(_mask[i] == '?' && _mask[i - 1] != '?'){
-            _subMasks.push_back(std::make_pair(current_start, i - 1));
+            _subMaskStart.push_back(current_start);
+            _subMaskEnd.push_back(i - 1);
 
-            while(_mask[i] == '?' && i < _mask.size()){
+            while(i < _mask.size() && _mask[i] == '?'){
                 i++;
             }
             current_start = i;
@@ -93,116 +251,745 @@ void AchoKorasic::subMasksInit(){
         i++;
     }
 
-    if(_mask[_mask.size() - 1] != '?'){
-        _subMasks.push_back(std::make_pair(current_start, _mask.size() - 1));
+    if(!_mask.empty() && _mask[_mask.size() - 1] != '?'){
+        _subMaskStart.push_back(current_start);
+        _subMaskEnd.push_back(_mask.size() - 1);
     }
 }
 
-void AchoKorasic::addSubMask(int start, int end, int pattern){
+int AchoKorasic::addNode(Edges& edges){
+    edges.emplace_back();
+    _suffLink.push_back(0);
+    _terminalLink.push_back(0);
+    _denseRow.push_back(-1);
+    return _suffLink.size() - 1;
+}
+
+void AchoKorasic::addSubMask(int start, int end, int pattern, Edges& edges, std::vector< std::pair< int, int > >& terminals){
     // функция добавляет подмаски в бор
     int current = 0;
     for(int i = start; i <= end; ++i){
-        char chr = _mask[i] - 'a';
-        if(_buffer[current].children[chr] == -1){
-            _buffer.push_back(Point(current, chr));
-            _buffer[current].children[chr] = _buffer.size() - 1;
+        unsigned char chr = _mask[i];
+
+        int next = -1;
+        for(int j = 0; j < edges[current].size(); ++j){
+            if(edges[current][j].first == chr){
+                next = edges[current][j].second;
+                break;
+            }
+        }
+        if(next == -1){
+            next = addNode(edges);
+            edges[current].push_back(std::make_pair(chr, next));
         }
-        current = _buffer[current].children[chr];
+        current = next;
     }
-    _buffer[current].isTerminal = true;
-    _buffer[current].patterns.push_back(pattern);
+    terminals.push_back(std::make_pair(current, pattern));
 }
 
-AchoKorasic::AchoKorasic(std::string& mask) : _mask(mask) {
-    _buffer.push_back(Point(0, -1, 0));
+void AchoKorasic::packChildren(Edges& edges){
+    _childMask.assign(4 * edges.size(), 0);
+    _childStart.resize(edges.size());
+    _children.clear();
+
+    for(int v = 0; v < edges.size(); ++v){
+        std::sort(edges[v].begin(), edges[v].end());
+        _childStart[v] = _children.size();
+
+        for(int j = 0; j < edges[v].size(); ++j){
+            unsigned char chr = edges[v][j].first;
+            _childMask[4 * v + (chr >> 6)] |= 1ull << (chr & 63);
+            _children.push_back(edges[v][j].second);
+        }
+    }
+}
+
+void AchoKorasic::buildPatternLists(const std::vector< std::pair< int, int > >& terminals){
+    // раскладываем пары (вершина, подмаска) сортировкой подсчетом по вершинам
+    _patternsStart.assign(_suffLink.size() + 1, 0);
+    for(int i = 0; i < terminals.size(); ++i){
+        ++_patternsStart[terminals[i].first + 1];
+    }
+    for(int v = 0; v < _suffLink.size(); ++v){
+        _patternsStart[v + 1] += _patternsStart[v];
+    }
+
+    std::vector< int > fill(_patternsStart.begin(), _patternsStart.end() - 1);
+    _patterns.resize(terminals.size());
+    for(int i = 0; i < terminals.size(); ++i){
+        _patterns[fill[terminals[i].first]++] = terminals[i].second;
+    }
+}
+
+AchoKorasic::AchoKorasic(std::string_view mask) : _mask(mask) {
+    Edges edges;
+    addNode(edges);
 
     subMasksInit();
 
-    for(int i = 0; i < _subMasks.size(); ++i){
-        addSubMask(_subMasks[i].first, _subMasks[i].second, i);
+    std::vector< std::pair< int, int > > terminals;
+    for(int i = 0; i < _subMaskStart.size(); ++i){
+        addSubMask(_subMaskStart[i], _subMaskEnd[i], i, edges, terminals);
+    }
+
+    packChildren(edges);
+    buildPatternLists(terminals);
+    refreshTables();
+    buildLinks();
+}
+
+template< class Visitor >
+void AchoKorasic::forEachTable(Tables& tables, Visitor visit){
+    visit(tables.mask, tables.maskSize);
+    visit(tables.childMask, 4ll * tables.nodes);
+    visit(tables.childStart, tables.nodes);
+    visit(tables.children, tables.childrenCount);
+    visit(tables.denseRow, tables.nodes);
+    visit(tables.dense, (long long)tables.denseRows * ALPHABET);
+    visit(tables.suffLink, tables.nodes);
+    visit(tables.terminalLink, tables.nodes);
+    visit(tables.patternsStart, tables.nodes + 1ll);
+    visit(tables.patterns, tables.patternsCount);
+    visit(tables.subMaskStart, tables.subMasks);
+    visit(tables.subMaskEnd, tables.subMasks);
+}
+
+void AchoKorasic::refreshTables(){
+    _tables.mask = _mask.data();
+    _tables.childMask = _childMask.data();
+    _tables.childStart = _childStart.data();
+    _tables.children = _children.data();
+    _tables.denseRow = _denseRow.data();
+    _tables.dense = _dense.data();
+    _tables.suffLink = _suffLink.data();
+    _tables.terminalLink = _terminalLink.data();
+    _tables.patternsStart = _patternsStart.data();
+    _tables.patterns = _patterns.data();
+    _tables.subMaskStart = _subMaskStart.data();
+    _tables.subMaskEnd = _subMaskEnd.data();
+
+    _tables.maskSize = _mask.size();
+    _tables.nodes = _suffLink.size();
+    _tables.childrenCount = _children.size();
+    _tables.denseRows = _dense.size() / ALPHABET;
+    _tables.patternsCount = _patterns.size();
+    _tables.subMasks = _subMaskStart.size();
+}
+
+void AchoKorasic::save(const char* path) const {
+    std::ofstream out(path, std::ios::binary);
+    if(!out){
+        throw std::runtime_error(std::string("cannot create ") + path);
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.maskSize = _tables.maskSize;
+    header.nodes = _tables.nodes;
+    header.childrenCount = _tables.childrenCount;
+    header.denseRows = _tables.denseRows;
+    header.patternsCount = _tables.patternsCount;
+    header.subMasks = _tables.subMasks;
+    header.alphabet = ALPHABET;
+    out.write(reinterpret_cast< const char* >(&header), sizeof(header));
+
+    // каждая таблица начинается с кратного 8 смещения, чтобы после mmap
+    // к ней можно было обращаться без копирования
+    const char padding[8] = {};
+    Tables tables = _tables;
+    forEachTable(tables, [&](auto*& table, long long count){
+        long long bytes = count * sizeof(*table);
+        out.write(reinterpret_cast< const char* >(table), bytes);
+        out.write(padding, (8 - bytes % 8) % 8);
+    });
+
+    if(!out.flush()){
+        throw std::runtime_error(std::string("cannot write ") + path);
     }
 }
 
-int AchoKorasic::buildSuffLink(int vertex){
-    // строим суффиксную ссылку, если надо, и возвращаем ее
-    if(_buffer[vertex].suffLink == -1){
+AchoKorasic AchoKorasic::load(const char* path){
+    AchoKorasic automaton;
+    automaton._file.reset(new MappedInput(path));
+    std::string_view data = automaton._file->data();
 
-        if(_buffer[vertex].parent == 0){
-            _buffer[vertex].suffLink = 0;
-        } else {
-            _buffer[vertex].suffLink = buildTerminateLink(buildSuffLink(_buffer[vertex].parent),
-                                                             _buffer[vertex].chr);
+    FileHeader header;
+    if(data.size() < sizeof(header)){
+        throw std::runtime_error(std::string(path) + ": file is too short");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if(std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+       header.byteOrder != BYTE_ORDER_MARK || header.alphabet != ALPHABET){
+        throw std::runtime_error(std::string(path) + ": not a compiled automaton");
+    }
+    if(header.version != FILE_VERSION){
+        throw std::runtime_error(std::string(path) + ": unsupported version " + std::to_string(header.version));
+    }
+
+    Tables& tables = automaton._tables;
+    tables.maskSize = header.maskSize;
+    tables.nodes = header.nodes;
+    tables.childrenCount = header.childrenCount;
+    tables.denseRows = header.denseRows;
+    tables.patternsCount = header.patternsCount;
+    tables.subMasks = header.subMasks;
+
+    size_t offset = sizeof(header);
+    bool truncated = false;
+    forEachTable(tables, [&](auto*& table, long long count){
+        long long bytes = count * sizeof(*table);
+        if(count < 0 || offset + bytes > data.size()){
+            truncated = true;
+            return;
+        }
+        table = reinterpret_cast< std::remove_reference_t< decltype(table) > >(data.data() + offset);
+        offset += bytes + (8 - bytes % 8) % 8;
+    });
+
+    if(truncated){
+        throw std::runtime_error(std::string(path) + ": file is truncated");
+    }
+
+    automaton._mask = std::string_view(tables.mask, tables.maskSize);
+    return automaton;
+}
+
+size_t AchoKorasic::memoryUsage() const {
+    // все таблицы, кроме самой маски
+    size_t bytes = 0;
+    Tables tables = _tables;
+    forEachTable(tables, [&](auto*& table, long long count){
+        bytes += count * sizeof(*table);
+    });
+    return bytes - _mask.size();
+}
+
+int AchoKorasic::nodesCount() const {
+    return _tables.nodes;
+}
+
+bool AchoKorasic::isTerminal(int vertex) const {
+    return _tables.patternsStart[vertex] != _tables.patternsStart[vertex + 1];
+}
+
+int AchoKorasic::child(int vertex, unsigned char chr) const {
+    const unsigned long long* mask = &_tables.childMask[4 * vertex];
+    int word = chr >> 6;
+    unsigned long long bit = 1ull << (chr & 63);
+
+    if((mask[word] & bit) == 0){
+        return -1;
+    }
+
+    int rank = __builtin_popcountll(mask[word] & (bit - 1));
+    for(int i = 0; i < word; ++i){
+        rank += __builtin_popcountll(mask[i]);
+    }
+    return _tables.children[_tables.childStart[vertex] + rank];
+}
+
+int AchoKorasic::next(int vertex, unsigned char chr) const {
+    while(true){
+        int row = _tables.denseRow[vertex];
+        if(row >= 0){
+            return _tables.dense[row * ALPHABET + chr];
+        }
+
+        int to = child(vertex, chr);
+        if(to >= 0){
+            return to;
+        }
+        vertex = _tables.suffLink[vertex];
+    }
+}
+
+void AchoKorasic::buildLinks(){
+    // вершины обрабатываются в порядке обхода в ширину, поэтому к моменту
+    // обработки v ее суффиксная ссылка и все вершины выше уже готовы
+    std::vector< int > queue;
+    std::vector< int > depth(_suffLink.size(), 0);
+    queue.reserve(_suffLink.size());
+    queue.push_back(0);
+
+    for(int head = 0; head < queue.size(); ++head){
+        int vertex = queue[head];
+        int link = _suffLink[vertex];
+        int begin = _childStart[vertex];
+        int end = (vertex + 1 < _childStart.size()) ? _childStart[vertex + 1] : _children.size();
+
+        // ребра бора: ссылка ребенка - переход из ссылки родителя
+        for(int word = 0, j = begin; word < 4; ++word){
+            for(unsigned long long bits = _childMask[4 * vertex + word]; bits != 0; bits &= bits - 1, ++j){
+                unsigned char chr = word * 64 + __builtin_ctzll(bits);
+                int to = _children[j];
+
+                int childLink = (vertex == 0) ? 0 : next(link, chr);
+                _suffLink[to] = childLink;
+                _terminalLink[to] = isTerminal(childLink) ? childLink : _terminalLink[childLink];
+                depth[to] = depth[vertex] + 1;
+                queue.push_back(to);
+            }
+        }
+
+        // корень, его дети и вершины с многими детьми получают плотную строку
+        int rows = _dense.size() / ALPHABET;
+        bool hot = depth[vertex] <= 1 || end - begin >= DENSE_CHILDREN;
+        if(vertex == 0 || (hot && rows < DENSE_LIMIT)){
+            _dense.resize(_dense.size() + ALPHABET);
+            refreshTables();
+            int* row = &_dense[rows * ALPHABET];
+
+            for(int chr = 0; chr < ALPHABET; ++chr){
+                int to = child(vertex, chr);
+                row[chr] = (to >= 0) ? to : ((vertex == 0) ? 0 : next(link, chr));
+            }
+            _denseRow[vertex] = rows;
         }
     }
-    return _buffer[vertex].suffLink;
 }
 
-int AchoKorasic::buildTerminateLink(int vertex, char chr){
-    // строим переход, если надо, и возвращаем его
-    if(_buffer[vertex].jumps[chr] == -1){
+template< class Vote >
+int AchoKorasic::step(int vertex, char chr, Vote vote) const {
+    vertex = next(vertex, chr);
+    // по терминальным ссылкам обходим только вершины, где кончаются подмаски
+    int terminal = isTerminal(vertex) ? vertex : _tables.terminalLink[vertex];
 
-        if(_buffer[vertex].children[chr] != -1){
-            _buffer[vertex].jumps[chr] = _buffer[vertex].children[chr];
-        } else if (vertex == 0){
-            _buffer[vertex].jumps[chr] = 0;
-        } else {
-            _buffer[vertex].jumps[chr] = buildTerminateLink(buildSuffLink(vertex), chr);
+    while(terminal != 0){
+        for(int j = _tables.patternsStart[terminal]; j < _tables.patternsStart[terminal + 1]; ++j){
+            vote(_tables.subMaskEnd[_tables.patterns[j]]);
         }
+        terminal = _tables.terminalLink[terminal];
+    }
+    return vertex;
+}
+
+void AchoKorasic::find(std::string_view text, std::vector< int >& ans, Engine engine) const {
+    if(engine == Engine::Auto){
+        engine = chooseEngine(text);
+    }
+
+    if(engine == Engine::Convolution){
+        findConvolution(text, ans);
+    } else {
+        findAutomaton(text, ans);
     }
-    return _buffer[vertex].jumps[chr];
 }
 
-void AchoKorasic::find(std::string& text, std::vector< int >& ans){
+void AchoKorasic::findAutomaton(std::string_view text, std::vector< int >& ans) const {
     // функция, которая ищет вхождения маски в текст и записывает их в ans
-    std::vector< int > entry(text.size());
+    if(text.size() < _mask.size()){
+        return;
+    }
+
+    // лишняя ячейка нужна пустой маске, которая входит и в позицию n
+    std::vector< int > entry(text.size() + 1);
     int vertex = 0;
 
     for(int i = 0; i < text.size(); ++i){
-        vertex = buildTerminateLink(vertex, text[i] - 'a');
-        int next = vertex;
+        vertex = step(vertex, text[i], [&](int end){
+            int tmp = i - end;
 
-        while(next != 0){
-            if(!_buffer[next].isTerminal){
-                next = buildSuffLink(next);
-                continue;
+            if(tmp >= 0 && tmp + _mask.size() <= text.size()){
+                entry[tmp]++;
+            }
+        });
+    }
+
+    for(int i = 0; i + _mask.size() <= text.size(); ++i){
+        if(entry[i] == _tables.subMasks){
+            ans.push_back(i);
+        }
+    }
+}
+
+
+double AchoKorasic::estimateOccurrences(std::string_view text) const {
+    std::vector< double > frequency(ALPHABET, 0);
+    for(int i = 0; i < text.size(); ++i){
+        frequency[(unsigned char)text[i]] += 1;
+    }
+    for(int chr = 0; chr < ALPHABET; ++chr){
+        frequency[chr] /= std::max< size_t >(1, text.size());
+    }
+
+    double total = 0;
+    for(int i = 0; i < _tables.subMasks; ++i){
+        double probability = 1;
+        for(int j = _tables.subMaskStart[i]; j <= _tables.subMaskEnd[i]; ++j){
+            probability *= frequency[(unsigned char)_mask[j]];
+        }
+        total += probability * text.size();
+    }
+    return total;
+}
+
+AchoKorasic::Engine AchoKorasic::chooseEngine(std::string_view text) const {
+    // стоимости в наносекундах подобраны по testing/bench.cpp:
+    // автомат ~ AUTOMATON_CHAR на символ и AUTOMATON_VOTE на вхождение подмаски,
+    // свертки ~ CONVOLUTION_CHAR * log2(4m) на символ
+    const double AUTOMATON_CHAR = 5.5;
+    const double AUTOMATON_VOTE = 1.5;
+    const double CONVOLUTION_CHAR = 23;
+
+    // пустой маске свертка не нужна, а log2(0) испортил бы оценку
+    if(_mask.empty() || _mask.size() > text.size() || !convolutionFits()){
+        return Engine::Automaton;
+    }
+
+    double automaton = AUTOMATON_CHAR * text.size() + AUTOMATON_VOTE * estimateOccurrences(text);
+    double convolution = CONVOLUTION_CHAR * text.size() * std::log2(4.0 * _mask.size());
+
+    return (convolution < automaton) ? Engine::Convolution : Engine::Automaton;
+}
+
+unsigned AchoKorasic::power(unsigned long long base, unsigned long long exp){
+    unsigned long long result = 1;
+    base %= MOD;
+    while(exp > 0){
+        if(exp & 1){
+            result = result * base % MOD;
+        }
+        base = base * base % MOD;
+        exp >>= 1;
+    }
+    return result;
+}
+
+void AchoKorasic::ntt(std::vector< unsigned >& a, bool invert){
+    int n = a.size();
+
+    for(int i = 1, j = 0; i < n; ++i){
+        int bit = n >> 1;
+        for(; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j){
+            std::swap(a[i], a[j]);
+        }
+    }
+
+    std::vector< unsigned > roots(n / 2);
+    for(int len = 2; len <= n; len <<= 1){
+        unsigned long long root = power(ROOT, (MOD - 1) / len);
+        if(invert){
+            root = power(root, MOD - 2);
+        }
+
+        int half = len / 2;
+        roots[0] = 1;
+        for(int k = 1; k < half; ++k){
+            roots[k] = roots[k - 1] * root % MOD;
+        }
+
+        for(int i = 0; i < n; i += len){
+            for(int k = 0; k < half; ++k){
+                unsigned u = a[i + k];
+                unsigned v = (unsigned long long)a[i + k + half] * roots[k] % MOD;
+                a[i + k] = (u + v >= MOD) ? u + v - MOD : u + v;
+                a[i + k + half] = (u >= v) ? u - v : u + MOD - v;
             }
+        }
+    }
 
-            for(int j = 0; j < _buffer[next].patterns.size(); ++j){
+    if(invert){
+        unsigned long long inverse = power(n, MOD - 2);
+        for(int i = 0; i < n; ++i){
+            a[i] = a[i] * inverse % MOD;
+        }
+    }
+}
+
+int AchoKorasic::convolutionCodes(std::vector< unsigned >& code) const {
+    code.assign(ALPHABET, 0);
+    for(int j = 0; j < _mask.size(); ++j){
+        if(_mask[j] != '?'){
+            code[(unsigned char)_mask[j]] = 1;
+        }
+    }
+
+    int k = 0;
+    for(int chr = 0; chr < ALPHABET; ++chr){
+        if(code[chr] != 0){
+            code[chr] = ++k;
+        }
+    }
+    return k;
+}
+
+bool AchoKorasic::convolutionFits() const {
+    std::vector< unsigned > code;
+    long long k = convolutionCodes(code);
+    return k * k * (long long)_mask.size() < MOD;
+}
+
+void AchoKorasic::findConvolution(std::string_view text, std::vector< int >& ans) const {
+    int n = text.size();
+    int m = _mask.size();
 
-                int tmp = i - _subMasks[_buffer[next].patterns[j]].second;
+    // слишком длинную маску над большим алфавитом свертки не различат по
+    // модулю; пустая маска входит в каждую позицию, и свертка для нее не нужна
+    if(m == 0 || !convolutionFits()){
+        findAutomaton(text, ans);
+        return;
+    }
+    if(m > n){
+        return;
+    }
+
+    std::vector< unsigned > code;
+    convolutionCodes(code);
+
+    // размер блока: степень двойки не меньше 4m, но не больше нужного для всего текста
+    int size = 1;
+    while(size < 4 * m && size < n + m){
+        size <<= 1;
+    }
+    while(size < 2 * m){
+        size <<= 1;
+    }
+    int step = size - m + 1;
+
+    // развернутая маска: w p и w, плюс константа sum w p^2
+    std::vector< unsigned > maskValues(size, 0);
+    std::vector< unsigned > maskWeights(size, 0);
+    unsigned long long constant = 0;
+    for(int j = 0; j < m; ++j){
+        if(_mask[j] != '?'){
+            unsigned value = code[(unsigned char)_mask[j]];
+            maskValues[m - 1 - j] = value;
+            maskWeights[m - 1 - j] = 1;
+            constant += value * value;
+        }
+    }
+    constant %= MOD;
+    ntt(maskValues, false);
+    ntt(maskWeights, false);
+
+    std::vector< unsigned > values(size);
+    std::vector< unsigned > squares(size);
+
+    for(int start = 0; start + m <= n; start += step){
+        for(int k = 0; k < size; ++k){
+            unsigned value = (start + k < n) ? code[(unsigned char)text[start + k]] : 0;
+            values[k] = value;
+            squares[k] = value * value;
+        }
+        ntt(values, false);
+        ntt(squares, false);
+
+        // w * t^2 - 2 (w p) * t в частотной области, одно обратное преобразование
+        for(int k = 0; k < size; ++k){
+            unsigned long long plus = (unsigned long long)maskWeights[k] * squares[k] % MOD;
+            unsigned long long minus = 2ull * maskValues[k] % MOD * values[k] % MOD;
+            values[k] = (plus + MOD - minus) % MOD;
+        }
+        ntt(values, true);
 
-                if(tmp >= 0 && tmp + _mask.size() <= text.size()){
-                    entry[tmp]++;
+        // позиция start + s лежит в свертке под индексом s + m - 1
+        for(int s = 0; s < step && start + s + m <= n; ++s){
+            if((values[s + m - 1] + constant) % MOD == 0){
+                ans.push_back(start + s);
+            }
+        }
+    }
+}
+
+void AchoKorasic::findBatch(const std::vector< std::string_view >& texts, std::vector< std::vector< int > >& ans) const {
+    ans.assign(texts.size(), std::vector< int >());
+
+    // курсор одного текста: голоса за начала вхождений как в findAutomaton
+    struct Lane{
+        int record = -1;
+        int pos = 0;
+        int vertex = 0;
+        std::vector< int > entry;
+    };
+    Lane lanes[BATCH_LANES];
+
+    int m = _mask.size();
+    int taken = 0;
+
+    // выдает курсору следующий текст, в котором маска вообще помещается
+    auto take = [&](Lane& lane){
+        while(taken < texts.size() && texts[taken].size() < m){
+            ++taken;
+        }
+        lane.record = (taken < texts.size()) ? taken++ : -1;
+        if(lane.record >= 0){
+            lane.pos = 0;
+            lane.vertex = 0;
+            lane.entry.assign(texts[lane.record].size() + 1, 0);
+        }
+        return lane.record >= 0;
+    };
+
+    int active = 0;
+    for(int l = 0; l < BATCH_LANES; ++l){
+        active += take(lanes[l]);
+    }
+
+    while(active > 0){
+        for(int l = 0; l < BATCH_LANES; ++l){
+            Lane& lane = lanes[l];
+            if(lane.record < 0){
+                continue;
+            }
+
+            std::string_view text = texts[lane.record];
+            if(lane.pos == text.size()){
+                std::vector< int >& found = ans[lane.record];
+                for(int i = 0; i + m <= text.size(); ++i){
+                    if(lane.entry[i] == _tables.subMasks){
+                        found.push_back(i);
+                    }
                 }
+                active -= !take(lane);
+                continue;
             }
-            next = buildSuffLink(next);
+
+            int i = lane.pos++;
+            lane.vertex = step(lane.vertex, text[i], [&](int end){
+                int tmp = i - end;
+
+                if(tmp >= 0 && tmp + m <= text.size()){
+                    lane.entry[tmp]++;
+                }
+            });
+
+            // к следующему символу этого текста очередь дойдет только через
+            // BATCH_LANES - 1 шагов других курсоров, строки вершины успеют подгрузиться
+            __builtin_prefetch(&_tables.denseRow[lane.vertex]);
+            __builtin_prefetch(&_tables.childMask[4 * lane.vertex]);
         }
     }
+}
 
-    for(int i = 0; i < entry.size(); ++i){
-        if(entry[i] == _subMasks.size()){
-            ans.push_back(i);
+
+class AchoKorasic::Stream{
+public:
+    // first - абсолютная позиция первого символа, который будет подан
+    explicit Stream(const AchoKorasic& automaton, long long first = 0);
+
+    // обрабатывает очередной кусок текста и дописывает в ans абсолютные
+    // позиции вхождений, которые уже не могут получить новых голосов.
+    // пустая маска входит в каждую поданную позицию; позицию за концом
+    // текста поток не видит, ее добавляет вызывающий
+    void feed(const char* chunk, size_t size, std::vector< long long >& ans);
+
+private:
+    const AchoKorasic& _automaton;
+    int _vertex = 0;
+
+    long long _first;
+    long long _processed;
+
+    // голоса за позицию s лежат в _votes[s % m]: s получает голоса, пока
+    // обрабатываются символы s .. s + m - 1, после чего ячейка освобождается.
+    // _head = _processed % m, чтобы не делить на каждом голосе
+    std::vector< int > _votes;
+    int _head;
+};
+
+AchoKorasic::Stream::Stream(const AchoKorasic& automaton, long long first)
+    : _automaton(automaton), _first(first), _processed(first), _votes(automaton._mask.size(), 0) {
+    _head = _votes.empty() ? 0 : first % _votes.size();
+}
+
+void AchoKorasic::Stream::feed(const char* chunk, size_t size, std::vector< long long >& ans){
+    int m = _votes.size();
+    int need = _automaton._tables.subMasks;
+
+    if(m == 0){
+        for(size_t i = 0; i < size; ++i){
+            ans.push_back(_processed++);
         }
+        return;
+    }
+
+    for(size_t i = 0; i < size; ++i){
+        _vertex = _automaton.step(_vertex, chunk[i], [&](int end){
+            if(_processed - end >= _first){
+                int slot = _head - end;
+                ++_votes[(slot < 0) ? slot + m : slot];
+            }
+        });
+
+        // позиция, для которой только что пришел последний символ окна,
+        // занимает следующую за _head ячейку
+        int slot = (_head + 1 == m) ? 0 : _head + 1;
+        long long done = _processed - m + 1;
+        if(done >= _first){
+            if(_votes[slot] == need){
+                ans.push_back(done);
+            }
+            _votes[slot] = 0;
+        }
+
+        _head = slot;
+        ++_processed;
     }
 }
 
 
-int main()
+void AchoKorasic::findParallel(std::string_view text, std::vector< int >& ans, int threads) const {
+    int n = text.size();
+    int m = _mask.size();
+    threads = std::max(1, std::min(threads, n));
+
+    // поток отвечает за начала вхождений из [begin, end) и читает текст
+    // до end + m - 1, то есть куски перекрываются на m - 1 символ
+    std::vector< std::vector< long long > > parts(threads);
+    auto worker = [&](int t){
+        int begin = (long long)n * t / threads;
+        int end = (long long)n * (t + 1) / threads;
+        int last = std::min< long long >(n, (long long)end + std::max(m - 1, 0));
+
+        Stream stream(*this, begin);
+        stream.feed(text.data() + begin, last - begin, parts[t]);
+    };
+
+    std::vector< std::thread > workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back(worker, t);
+    }
+
+    for(int t = 0; t < threads; ++t){
+        workers[t].join();
+        ans.insert(ans.end(), parts[t].begin(), parts[t].end());
+    }
+
+    // пустая маска входит и в позицию n, которой нет ни в одном куске
+    if(m == 0){
+        ans.push_back(n);
+    }
+}
+
+
+int main(int argc, char** argv)
 {
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
-    std::string pattern = "";
-    std::string text = "";
-    std::cin >> pattern >> text;
+    // вход отображается в память, маска и текст - окна на его страницы
+    MappedInput input(argc > 1 ? argv[1] : nullptr);
+
+    std::string_view pattern = input.next();
+    std::string_view text = input.next();
 
     AchoKorasic achoKorasic(pattern);
 
     std::vector< int > ans;
     achoKorasic.find(text, ans);
 
+    OutputWriter output;
     for(int i = 0; i < ans.size(); ++i){
-        std::cout << ans[i] << " ";
+        output.write(ans[i]);
+        output.write(' ');
     }
 
     return 0;
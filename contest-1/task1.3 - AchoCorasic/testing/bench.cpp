@@ -0,0 +1,228 @@
+// Замеры AchoKorasic: построение, память, скорость поиска.
+//     g++ -std=c++17 -O2 -pthread bench.cpp -o bench && ./bench
+#define main solution_main
+#include "../task1.3 - AchoCorasic.cpp"
+#undef main
+
+#include <chrono>
+#include <malloc.h>
+#include <random>
+#include <string>
+
+#include "../../../common/benchmark.h"
+
+// занятая память кучи, включая большие блоки, которые malloc берет через mmap
+size_t heapInUse(){
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+int main()
+{
+    std::mt19937 rng(179);
+
+    // маска длины 5000 из коротких подмасок над a-d, текст 2 * 10^6 символов
+    // с вписанными в него вхождениями маски
+    std::string mask = randomString(rng, 5000, 4);
+    for(int i = 0; i < mask.size(); ++i){
+        if(rng() % 4 == 0){
+            mask[i] = '?';
+        }
+    }
+    std::string text = randomString(rng, 2000000, 4);
+    for(int start = 0; start + mask.size() <= text.size(); start += 50000){
+        for(int j = 0; j < mask.size(); ++j){
+            if(mask[j] != '?'){
+                text[start + j] = mask[j];
+            }
+        }
+    }
+
+    size_t heapBefore = heapInUse();
+    auto start = std::chrono::steady_clock::now();
+    AchoKorasic achoKorasic(mask);
+    double build = seconds(start);
+    size_t heap = heapInUse() - heapBefore;
+
+    std::cout << "build:  " << build * 1e3 << " ms\n";
+    std::cout << "memory: " << heap / 1024 << " KB on heap, memoryUsage() " << achoKorasic.memoryUsage() / 1024
+              << " KB, " << achoKorasic.memoryUsage() / achoKorasic.nodesCount() << " B per node\n";
+
+    std::vector< int > ans;
+    start = std::chrono::steady_clock::now();
+    achoKorasic.find(text, ans);
+    double search = seconds(start);
+    std::cout << "search: " << text.size() / search / 1e6 << " MB/s, " << ans.size() << " matches\n";
+
+    // байтовый алфавит: маска и текст из произвольных байт
+    std::string byteMask(5000, 0);
+    for(int i = 0; i < byteMask.size(); ++i){
+        byteMask[i] = (rng() % 8 == 0) ? '?' : (char)(rng() % 256);
+        if(byteMask[i] == '?' && i % 8 != 0){
+            byteMask[i] = 0;
+        }
+    }
+    std::string byteText(2000000, 0);
+    for(int i = 0; i < byteText.size(); ++i){
+        byteText[i] = rng() % 256;
+    }
+
+    AchoKorasic byteAutomaton(byteMask);
+    std::vector< int > byteAns;
+    start = std::chrono::steady_clock::now();
+    byteAutomaton.find(byteText, byteAns, AchoKorasic::Engine::Automaton);
+    double byteSearch = seconds(start);
+    std::cout << "bytes:  " << byteAutomaton.nodesCount() << " nodes, "
+              << byteAutomaton.memoryUsage() / byteAutomaton.nodesCount() << " B per node, "
+              << byteText.size() / byteSearch / 1e6 << " MB/s\n";
+
+    // большой словарь: построение против загрузки скомпилированного файла.
+    // load() только отображает файл, поэтому его время почти не зависит от размера
+    std::string bigMask(1000000, 0);
+    for(int i = 0; i < bigMask.size(); ++i){
+        bigMask[i] = (i % 16 == 15) ? '?' : (char)(rng() % 256);
+    }
+
+    start = std::chrono::steady_clock::now();
+    AchoKorasic bigAutomaton(bigMask);
+    double bigBuild = seconds(start);
+
+    const char* compiled = "bench_automaton.bin";
+    start = std::chrono::steady_clock::now();
+    bigAutomaton.save(compiled);
+    double bigSave = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    AchoKorasic loaded = AchoKorasic::load(compiled);
+    double bigLoad = seconds(start);
+
+    std::vector< int > builtAns, loadedAns;
+    bigAutomaton.find(byteText, builtAns, AchoKorasic::Engine::Automaton);
+    start = std::chrono::steady_clock::now();
+    loaded.find(byteText, loadedAns, AchoKorasic::Engine::Automaton);
+    double loadedSearch = seconds(start);
+    std::remove(compiled);
+
+    std::cout << "compiled: " << bigAutomaton.nodesCount() << " nodes, " << bigAutomaton.memoryUsage() / 1024 / 1024
+              << " MB; build " << bigBuild * 1e3 << " ms, save " << bigSave * 1e3 << " ms, load "
+              << bigLoad * 1e3 << " ms, first search after load " << byteText.size() / loadedSearch / 1e6 << " MB/s"
+              << (builtAns == loadedAns ? "" : "  MISMATCH") << "\n";
+
+    // миллион коротких записей над a-d против маски длины 12: по одной
+    // через find() и пачкой через findBatch()
+    std::string recordMask = randomString(rng, 12, 4);
+    recordMask[3] = recordMask[8] = '?';
+    AchoKorasic recordAutomaton(recordMask);
+
+    std::string records;
+    std::vector< size_t > bounds(1, 0);
+    for(int r = 0; r < 1000000; ++r){
+        records += randomString(rng, 16 + rng() % 113, 4);
+        bounds.push_back(records.size());
+    }
+    std::vector< std::string_view > batch;
+    for(int r = 0; r + 1 < bounds.size(); ++r){
+        batch.push_back(std::string_view(records).substr(bounds[r], bounds[r + 1] - bounds[r]));
+    }
+
+    std::vector< std::vector< int > > single(batch.size()), batched;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < batch.size(); ++r){
+        recordAutomaton.find(batch[r], single[r], AchoKorasic::Engine::Automaton);
+    }
+    double singleTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    recordAutomaton.findBatch(batch, batched);
+    double batchTime = seconds(start);
+
+    std::cout << "records: find " << batch.size() / singleTime / 1e6 << " M/s, findBatch "
+              << batch.size() / batchTime / 1e6 << " M/s (" << records.size() / batchTime / 1e6 << " MB/s)"
+              << (single == batched ? "" : "  MISMATCH") << "\n";
+
+    // масштабирование findParallel по числу потоков
+    int maxThreads = std::max< int >(16, std::thread::hardware_concurrency());
+    for(int threads = 1; threads <= maxThreads; threads *= 2){
+        std::vector< int > parallel;
+        start = std::chrono::steady_clock::now();
+        achoKorasic.findParallel(text, parallel, threads);
+        double time = seconds(start);
+
+        std::cout << "findParallel(" << threads << "): " << text.size() / time / 1e6 << " MB/s, speedup "
+                  << search / time << (parallel == ans ? "" : "  MISMATCH") << "\n";
+    }
+
+    // Stream: тот же текст кусками случайной длины, от байтов до нескольких
+    // длин маски, чтобы кольцо голосов переходило через границы feed()
+    {
+        AchoKorasic::Stream stream(achoKorasic);
+        std::vector< long long > streamed;
+        start = std::chrono::steady_clock::now();
+        for(size_t offset = 0; offset < text.size(); ){
+            size_t size = (rng() % 2) ? 1 + rng() % 16 : 1 + rng() % (4 * mask.size());
+            size = std::min(size, text.size() - offset);
+            stream.feed(text.data() + offset, size, streamed);
+            offset += size;
+        }
+        double time = seconds(start);
+
+        std::cout << "Stream by chunks: " << text.size() / time / 1e6 << " MB/s"
+                  << (streamed == std::vector< long long >(ans.begin(), ans.end()) ? "" : "  MISMATCH") << "\n";
+    }
+
+    // неудобные маски над текстом из одних a:
+    //     a?a?...a?   - тысячи одинаковых подмасок, Z ~ n * m / 2
+    //     a^1000?a    - длинная подмаска, цепочка суффиксных ссылок из 1000
+    //                   вершин, из которых терминальны только две
+    std::string flat(200000, 'a');
+    std::string alternating;
+    for(int i = 0; i < 100; ++i){
+        alternating += "a?";
+    }
+    std::string deep = std::string(1000, 'a') + "?a";
+
+    std::string_view masks[] = {alternating, deep};
+    for(std::string_view adversarial : masks){
+        AchoKorasic automaton(adversarial);
+
+        std::vector< int > found;
+        start = std::chrono::steady_clock::now();
+        automaton.find(flat, found);
+        double time = seconds(start);
+
+        std::cout << "mask " << adversarial.substr(0, 8) << "... (m = " << adversarial.size() << "): "
+                  << time * 1e3 << " ms, " << found.size() << " matches\n";
+    }
+
+    // где пересекаются автомат и свертки: маска длины 2000 из подмасок длины
+    // len через один ?, текст над a-b. чем короче подмаски, тем больше Z
+    std::string binary = randomString(rng, 2000000, 2);
+    std::cout << "len  Z estimate  automaton ms  convolution ms  auto picks\n";
+
+    for(int len = 1; len <= 64; len *= 2){
+        std::string crossMask;
+        while(crossMask.size() + len + 1 <= 2000){
+            crossMask += randomString(rng, len, 2) + "?";
+        }
+        crossMask += randomString(rng, 2000 - crossMask.size(), 2);
+
+        AchoKorasic automaton(crossMask);
+        double times[2];
+        std::vector< int > found[2];
+        AchoKorasic::Engine engines[] = {AchoKorasic::Engine::Automaton, AchoKorasic::Engine::Convolution};
+
+        for(int e = 0; e < 2; ++e){
+            start = std::chrono::steady_clock::now();
+            automaton.find(binary, found[e], engines[e]);
+            times[e] = seconds(start);
+        }
+
+        bool convolutionPicked = automaton.chooseEngine(binary) == AchoKorasic::Engine::Convolution;
+        std::cout << len << "  " << (long long)automaton.estimateOccurrences(binary) << "  "
+                  << times[0] * 1e3 << "  " << times[1] * 1e3 << "  "
+                  << (convolutionPicked ? "convolution" : "automaton")
+                  << (found[0] == found[1] ? "" : "  MISMATCH") << "\n";
+    }
+
+    return 0;
+}
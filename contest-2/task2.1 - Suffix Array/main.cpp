@@ -7,168 +7,878 @@
     developed by Crashdown
 
  */
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
-class ProblemSolver{
+#include "../../common/fmindex.h"
+#include "../../common/mappedarray.h"
+#include "../../common/mappedinput.h"
+#include "../../common/packedarray.h"
+#include "../../common/paralleldoubling.h"
+
+//  Минимум на отрезке за O(1) при O(n) памяти: массив режется на блоки по 64,
+//  минимумы блоков лежат в разреженной таблице, а внутри блока для каждой
+//  позиции r хранится битовая маска стека минимумов на префиксе блока до r.
+//  минимум на [l, r] внутри блока - младший бит маски r не левее l
+template< class Index, class Array >
+class RangeMinimum{
 
 public:
-    ProblemSolver(std::string& str);
+    RangeMinimum() = default;
+    explicit RangeMinimum(const Array& values);
+
+    // минимум values[l..r], l <= r. values - тот же массив, что в конструкторе
+    Index query(const Array& values, Index l, Index r) const;
 
-    int substringsCount();
+    size_t memoryUsage() const;
 
+    // построен ли индекс (объект не создан конструктором по умолчанию)
+    bool empty() const;
 
 private:
-    std::string& _str;
+    static const int BLOCK = 64;
+
+    // позиция минимума values[l..r] внутри одного блока
+    Index inBlock(Index l, Index r) const;
+
+    std::vector< unsigned long long > _stackMask;
+    // _sparse[k][b] - минимум блоков b .. b + 2^k - 1. таблица в n / 64 раз
+    // меньше массива, поэтому всегда обычный вектор, даже над PackedArray
+    std::vector< std::vector< Index > > _sparse;
+};
+
+//  Index - тип индексов: int для строк короче 2^31, long long для длинных.
+//  Array - хранилище массивов длины n: std::vector< Index >, PackedArray
+//  (40 бит на число, 5n байт вместо 8n при Index = long long) или
+//  MappedArray< Index > для индекса, загруженного с диска через load()
+template< class Index = int, class Array = std::vector< Index > >
+class ProblemSolver{
+
+public:
+    // способ построения суффиксного массива: удвоение префиксов за O(n log n),
+    // оно же на threads потоках или индуцированная сортировка SA-IS за O(n).
+    // результат одинаковый
+    enum class Engine { Doubling, ParallelDoubling, InducedSorting };
+
+    // строка не копируется и должна жить дольше объекта
+    ProblemSolver(std::string_view str, Engine engine = Engine::InducedSorting, int threads = 1);
+
+    long long substringsCount();
 
-    std::vector< int > suffArray;
-    std::vector< int > lcp;
+    // суффиксный массив вместе с пустым суффиксом, который всегда первый
+    const Array& suffixArray() const;
 
-    void buildSuffArray();
+    // индекс для LCP произвольных суффиксов: обратный массив и около 8 байт
+    // на элемент сверх массивов, запросы ниже за O(1). без него запросы
+    // не работают
+    void buildLCPIndex();
+
+    // длина общего префикса суффиксов str[i..] и str[j..]
+    Index longestCommonPrefix(Index i, Index j) const;
+
+    // сравнение подстрок str[i, i + len1) и str[j, j + len2) за O(1):
+    // отрицательное, ноль или положительное, как у std::string_view::compare
+    int compareSubstrings(Index i, Index len1, Index j, Index len2) const;
+
+    // число вхождений pattern. двоичный поиск по суффиксному массиву не
+    // сравнивает символы, уже совпавшие с границами отрезка: после
+    // buildLCPIndex за O(m + log n), без него за O(m log n) в худшем случае.
+    // пустой шаблон входит во все n + 1 позиций
+    Index count(std::string_view pattern) const;
+
+    // позиции всех вхождений pattern по возрастанию
+    void locate(std::string_view pattern, std::vector< Index >& positions) const;
+
+    // counts[q] = count(patterns[q]). шаблоны обрабатываются в лексикографическом
+    // порядке: поиск следующего начинается с границ предыдущего, а соседние
+    // запросы читают близкие участки суффиксного массива
+    void countBatch(const std::vector< std::string_view >& patterns, std::vector< Index >& counts) const;
+
+    // сжатый индекс для count и locate по этому суффиксному массиву:
+    // около 1.4n байт при sampleRate = 32 вместо строки и массивов. решатель
+    // после этого можно удалить, индексу строка уже не нужна
+    FMIndex< Index > compress(int sampleRate = 32) const;
+
+    // сохраняет строку, суффиксный массив, lcp и обратный массив в файл:
+    // заголовок с версией, размером индекса и контрольной суммой, затем
+    // массивы по sizeof(Index) байт на элемент с выравниванием на 8 байт
+    void save(const char* path) const;
+
+    // открывает файл, записанный save() с тем же Index. с Array =
+    // MappedArray< Index > массивы и строка - окна на отображенные страницы,
+    // которые процессы с одним файлом делят между собой; с std::vector
+    // и PackedArray они копируются в память. verify - пересчитать
+    // контрольную сумму, это читает весь файл. бросает std::runtime_error
+    // на чужом или битом файле
+    static ProblemSolver load(const char* path, bool verify = false);
+
+
+private:
+    // пустой объект, который заполняет load()
+    ProblemSolver() = default;
+
+    struct FileHeader{
+        char magic[8];
+        unsigned version;
+        unsigned byteOrder;
+        unsigned indexBytes;
+        unsigned reserved;
+        long long textSize;
+        unsigned long long checksum;
+    };
+
+    static const unsigned FILE_VERSION = 1;
+    static const unsigned BYTE_ORDER_MARK = 0x01020304;
+    static constexpr char FILE_MAGIC[8] = "SUFFARR";
+
+    // FNV-1a по 8-байтным словам всего, что лежит после заголовка
+    static unsigned long long checksum(std::string_view payload);
+
+    // длина совпадения pattern с суффиксом position, начиная с символа from
+    Index match(std::string_view pattern, Index position, Index from) const;
+
+    // первый ранг, суффикс которого больше pattern. если upper == false,
+    // суффикс, начинающийся с pattern, тоже считается большим, иначе - нет.
+    // from - ранг, суффикс которого заведомо не больше pattern
+    Index searchBound(std::string_view pattern, bool upper, Index from = 0) const;
+
+    //  запрос к RMQ дороже сравнения нескольких десятков символов подряд,
+    //  поэтому LCP-LR включается, только когда l и r расходятся сильнее.
+    //  это добавляет не больше LCP_LR_GAP символов на шаг: O(m + log n)
+    static const int LCP_LR_GAP = 32;
+
+    std::string_view _str;
+    //  длина строки вместе с терминальным символом, который не хранится,
+    //  а подставляется функцией symbol()
+    Index _size;
+
+    //  алфавит всех способов построения: терминальный символ 0, байт c - это
+    //  c + 1, так что терминальный символ меньше любого байта, даже '\0'
+    static constexpr int ALPHABET = 257;
+
+    int symbol(Index i) const;
+
+    Array suffArray;
+    Array lcp;
+    //  обратный суффиксный массив: _rank[suffArray[k]] = k. нужен только
+    //  запросам LCP, поэтому хранится после buildLCPIndex или load, а
+    //  buildLCP и save считают его во временный массив
+    Array _rank;
+
+    RangeMinimum< Index, Array > _lcpMinimum;
+
+    //  отображение файла, из которого загружен индекс; у построенного пусто
+    std::unique_ptr< MappedInput > _file;
+
+    void buildSuffArray(Engine engine, int threads);
+    void buildSuffArrayDoubling();
+    void buildSuffArrayInduced();
     void buildLCP();
+
+    // _rank, если он есть, иначе обратный массив, посчитанный в scratch.
+    // у загруженного индекса _rank есть всегда, MappedArray не заполняется
+    const Array& inverse(Array& scratch) const;
+
+    // SA-IS для строки s над алфавитом 0..alphabet-1, в которой последний
+    // символ - единственный минимальный. рекурсивно вызывается для строки
+    // из имен LMS-подстрок, которая в два раза короче
+    static void inducedSort(const Array& s, Index alphabet, Array& sa);
 };
 
 
-ProblemSolver::ProblemSolver(std::string& str) : _str(str){
-    _str += '\0';
+template< class Index, class Array >
+RangeMinimum< Index, Array >::RangeMinimum(const Array& values){
+    Index size = values.size();
+    Index blocks = (size + BLOCK - 1) / BLOCK;
+    _stackMask.assign(size, 0);
+
+    //  стек позиций с возрастающими значениями, бит j - позиция начала блока + j.
+    //  равные значения не выталкиваются, поэтому находится левый минимум
+    std::vector< Index > blockMinimum(blocks);
+    for(Index block = 0; block < blocks; ++block){
+        Index begin = block * BLOCK;
+        Index end = std::min(size, begin + BLOCK);
+        unsigned long long stack = 0;
+
+        for(Index i = begin; i < end; ++i){
+            while(stack != 0 && values[begin + 63 - __builtin_clzll(stack)] > values[i]){
+                stack ^= 1ull << (63 - __builtin_clzll(stack));
+            }
+            stack |= 1ull << (i - begin);
+            _stackMask[i] = stack;
+        }
+        blockMinimum[block] = values[begin + __builtin_ctzll(stack)];
+    }
+
+    _sparse.push_back(std::move(blockMinimum));
+    for(Index width = 1; 2 * width <= blocks; width <<= 1){
+        const std::vector< Index >& previous = _sparse.back();
+        std::vector< Index > level(blocks - 2 * width + 1);
+        for(Index b = 0; b < level.size(); ++b){
+            level[b] = std::min< Index >(previous[b], previous[b + width]);
+        }
+        _sparse.push_back(std::move(level));
+    }
+}
+
+template< class Index, class Array >
+Index RangeMinimum< Index, Array >::inBlock(Index l, Index r) const {
+    Index begin = r - r % BLOCK;
+    unsigned long long stack = _stackMask[r] & (~0ull << (l - begin));
+    return begin + __builtin_ctzll(stack);
+}
+
+template< class Index, class Array >
+Index RangeMinimum< Index, Array >::query(const Array& values, Index l, Index r) const {
+    Index left = l / BLOCK;
+    Index right = r / BLOCK;
+    if(left == right){
+        return values[inBlock(l, r)];
+    }
 
-    buildSuffArray();
+    Index result = std::min< Index >(values[inBlock(l, left * BLOCK + BLOCK - 1)],
+                                      values[inBlock(right * BLOCK, r)]);
+    if(left + 1 < right){
+        int level = 63 - __builtin_clzll(right - left - 1);
+        const std::vector< Index >& table = _sparse[level];
+        result = std::min< Index >(result, std::min< Index >(table[left + 1], table[right - (1ll << level)]));
+    }
+    return result;
+}
+
+template< class Index, class Array >
+bool RangeMinimum< Index, Array >::empty() const {
+    return _sparse.empty();
+}
+
+template< class Index, class Array >
+size_t RangeMinimum< Index, Array >::memoryUsage() const {
+    size_t bytes = _stackMask.size() * sizeof(unsigned long long);
+    for(int k = 0; k < _sparse.size(); ++k){
+        bytes += _sparse[k].size() * sizeof(Index);
+    }
+    return bytes;
+}
+
+
+template< class Index, class Array >
+ProblemSolver< Index, Array >::ProblemSolver(std::string_view str, Engine engine, int threads) : _str(str){
+    _size = _str.size() + 1;
+
+    buildSuffArray(engine, threads);
     buildLCP();
 }
 
-void ProblemSolver::buildSuffArray(){
+template< class Index, class Array >
+const Array& ProblemSolver< Index, Array >::suffixArray() const {
+    return suffArray;
+}
+
+template< class Index, class Array >
+int ProblemSolver< Index, Array >::symbol(Index i) const {
+    return (i < _str.size()) ? (unsigned char)_str[i] + 1 : 0;
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::buildSuffArray(Engine engine, int threads){
+    if(engine == Engine::InducedSorting){
+        buildSuffArrayInduced();
+    } else if(engine == Engine::ParallelDoubling){
+        //  параллельное удвоение держит свои буферы в std::vector< Index >
+        std::vector< Index > perm;
+        ParallelDoubling< Index >(threads).build(_size, [this](Index i){ return symbol(i); }, perm, 9);
+
+        suffArray.assign(_size, 0);
+        for(Index i = 0; i < _size; ++i){
+            suffArray[i] = perm[i];
+        }
+    } else {
+        buildSuffArrayDoubling();
+    }
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::buildSuffArrayDoubling(){
 
-    int numEqClasses = 1;
-    std::vector< int > perm(_str.size());
-    std::vector< int > eqClasses(_str.size());
+    Index numEqClasses = 1;
+    Array perm(_size);
+    Array eqClasses(_size);
 
-    //  выпонляем нулевыю фазу алгоритма сортировкой подсчетом
-    std::vector< int > cnt(256, 0);
+    //  выпонляем нулевыю фазу алгоритма сортировкой подсчетом.
+    //  в следующих фазах классов эквивалентности бывает до _size
+    Array cnt(std::max< Index >(ALPHABET, _size), 0);
 
-    for(int i = 0; i < _str.size(); ++i){
-        ++cnt[_str[i]];
+    for(Index i = 0; i < _size; ++i){
+        ++cnt[symbol(i)];
     }
 
-    for(int i = 1; i < 256; ++i){
+    for(int i = 1; i < ALPHABET; ++i){
         cnt[i] += cnt[i - 1];
     }
 
-    for(int i = 0; i < _str.size(); ++i){
-        perm[--cnt[_str[i]]] = i;
+    for(Index i = 0; i < _size; ++i){
+        perm[--cnt[symbol(i)]] = i;
     }
 
     eqClasses[perm[0]] = 0;
-    for(int i = 1; i < _str.size(); ++i){
-        if(_str[perm[i]] != _str[perm[i - 1]]){
+    for(Index i = 1; i < _size; ++i){
+        if(symbol(perm[i]) != symbol(perm[i - 1])){
             ++numEqClasses;
         }
         eqClasses[perm[i]] = numEqClasses - 1;
     }
 
-    //  итеративно выполняем остальные фазы алгоритма, используя для
-    //  временного хранения данных новой итерации массивы
-    //  _perm_tmp и _eqClasses_tmp
+    //  итеративно выполняем остальные фазы алгоритма. буферы shifted и
+    //  nextClasses заводятся один раз, классы новой фазы пишутся в nextClasses
+    //  и меняются местами с eqClasses. как только все классы различны,
+    //  порядок окончательный и следующие фазы его не меняют
 
-    for(int i = 0; (1 << i) < _str.size(); ++i){
-        std::vector< int > _perm_tmp(_str.size());
-        std::vector< int > _eqClasses_tmp(_str.size());
+    Array shifted(_size);
+    Array nextClasses(_size);
 
-        for(int j = 0; j < _str.size(); ++j){
-            _perm_tmp[j] = perm[j] - (1 << i);
-
-            if(_perm_tmp[j] < 0){
-                _perm_tmp[j] += _str.size();
-            }
+    for(Index shift = 1; shift < _size && numEqClasses < _size; shift <<= 1){
+        for(Index j = 0; j < _size; ++j){
+            Index from = perm[j] - shift;
+            shifted[j] = (from < 0) ? from + _size : from;
         }
 
-        for(int j = 0; j < numEqClasses; ++j){
+        for(Index j = 0; j < numEqClasses; ++j){
             cnt[j] = 0;
         }
 
-        for(int j = 0; j < _str.size(); ++j){
-            ++cnt[eqClasses[_perm_tmp[j]]];
+        for(Index j = 0; j < _size; ++j){
+            ++cnt[eqClasses[shifted[j]]];
         }
 
-        for(int j = 1; j < numEqClasses; ++j){
+        for(Index j = 1; j < numEqClasses; ++j){
             cnt[j] += cnt[j - 1];
         }
 
-        for(int j = _str.size() - 1; j >= 0; --j){
-            perm[--cnt[eqClasses[_perm_tmp[j]]]] = _perm_tmp[j];
+        for(Index j = _size - 1; j >= 0; --j){
+            perm[--cnt[eqClasses[shifted[j]]]] = shifted[j];
         }
 
 
-        _eqClasses_tmp[perm[0]] = 0;
+        nextClasses[perm[0]] = 0;
         numEqClasses = 1;
 
-        for(int j = 1; j < _str.size(); ++j){
-            int tmp1 = (perm[j] + (1 << i)) % _str.size();
-            int tmp2 = (perm[j - 1] + (1 << i)) % _str.size();
+        for(Index j = 1; j < _size; ++j){
+            Index tmp1 = perm[j] + shift;
+            Index tmp2 = perm[j - 1] + shift;
+            tmp1 -= (tmp1 >= _size) ? _size : 0;
+            tmp2 -= (tmp2 >= _size) ? _size : 0;
             if(eqClasses[perm[j]] != eqClasses[perm[j - 1]] ||
                eqClasses[tmp1] != eqClasses[tmp2]){
                 ++numEqClasses;
             }
-            _eqClasses_tmp[perm[j]] = numEqClasses - 1;
+            nextClasses[perm[j]] = numEqClasses - 1;
         }
 
-        eqClasses = std::move(_eqClasses_tmp);
+        eqClasses.swap(nextClasses);
     }
 
     suffArray = std::move(perm);
 }
 
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::buildSuffArrayInduced(){
+    //  symbol() уже дает терминальному символу 0 - единственный минимальный
+    Array s(_size);
+    for(Index i = 0; i < _size; ++i){
+        s[i] = symbol(i);
+    }
+
+    inducedSort(s, ALPHABET, suffArray);
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::inducedSort(const Array& s, Index alphabet, Array& sa){
+    Index n = s.size();
+    sa.assign(n, -1);
+    if(n == 1){
+        sa[0] = 0;
+        return;
+    }
+
+    //  суффикс i типа S, если он меньше суффикса i + 1, иначе типа L.
+    //  LMS - суффикс типа S, перед которым стоит суффикс типа L
+    std::vector< bool > sType(n, false);
+    sType[n - 1] = true;
+    for(Index i = n - 2; i >= 0; --i){
+        sType[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && sType[i + 1]);
+    }
+    auto isLms = [&](Index i){
+        return i > 0 && sType[i] && !sType[i - 1];
+    };
+
+    //  корзины по первому символу: [bucketStart[c], bucketStart[c + 1])
+    Array bucketStart(alphabet + 1, 0);
+    for(Index i = 0; i < n; ++i){
+        ++bucketStart[s[i] + 1];
+    }
+    for(Index c = 0; c < alphabet; ++c){
+        bucketStart[c + 1] += bucketStart[c];
+    }
+
+    Array bucket(alphabet);
+
+    //  LMS-суффиксы в заданном порядке кладутся в концы корзин, по ним
+    //  слева направо расставляются L-суффиксы, затем справа налево S-суффиксы
+    auto induce = [&](const Array& lms){
+        sa.assign(n, -1);
+
+        for(Index c = 0; c < alphabet; ++c){
+            bucket[c] = bucketStart[c + 1];
+        }
+        for(Index i = (Index)lms.size() - 1; i >= 0; --i){
+            sa[--bucket[s[lms[i]]]] = lms[i];
+        }
 
-void ProblemSolver::buildLCP(){
-    lcp.resize(_str.size(), 0);
+        for(Index c = 0; c < alphabet; ++c){
+            bucket[c] = bucketStart[c];
+        }
+        for(Index i = 0; i < n; ++i){
+            Index j = sa[i] - 1;
+            if(j >= 0 && !sType[j]){
+                sa[bucket[s[j]]++] = j;
+            }
+        }
+
+        for(Index c = 0; c < alphabet; ++c){
+            bucket[c] = bucketStart[c + 1];
+        }
+        for(Index i = n - 1; i >= 0; --i){
+            Index j = sa[i] - 1;
+            if(j >= 0 && sType[j]){
+                sa[--bucket[s[j]]] = j;
+            }
+        }
+    };
 
-    std::vector< int > reversed(suffArray.size());
-    for(int i = 0; i < suffArray.size(); ++i){
-        reversed[suffArray[i]] = i;
+    Index lmsCount = 0;
+    for(Index i = 1; i < n; ++i){
+        lmsCount += isLms(i);
+    }
+    Array lms(lmsCount);
+    for(Index i = 1, k = 0; i < n; ++i){
+        if(isLms(i)){
+            lms[k++] = i;
+        }
     }
 
-    int pos = 0;
+    //  после первой индукции LMS-подстроки отсортированы, даем им имена
+    induce(lms);
+
+    Array name(n, -1);
+    Index names = 0;
+    Index prev = -1;
+    for(Index i = 0; i < n; ++i){
+        Index cur = sa[i];
+        if(!isLms(cur)){
+            continue;
+        }
 
-    for(int i = 0; i < _str.size(); ++i){
+        bool differ = (prev < 0);
+        for(Index d = 0; !differ; ++d){
+            if(s[cur + d] != s[prev + d] || sType[cur + d] != sType[prev + d]){
+                differ = true;
+            } else if(d > 0 && isLms(cur + d)){
+                break;
+            }
+        }
+
+        if(differ){
+            ++names;
+        }
+        name[cur] = names - 1;
+        prev = cur;
+    }
+
+    //  порядок LMS-суффиксов: рекурсивно, если имена повторяются
+    Array reduced(lmsCount);
+    for(Index i = 0; i < lmsCount; ++i){
+        reduced[i] = name[lms[i]];
+    }
+
+    Array reducedSa(lmsCount);
+    if(names < lmsCount){
+        inducedSort(reduced, names, reducedSa);
+    } else {
+        for(Index i = 0; i < lmsCount; ++i){
+            reducedSa[reduced[i]] = i;
+        }
+    }
+
+    Array sortedLms(lmsCount);
+    for(Index i = 0; i < lmsCount; ++i){
+        sortedLms[i] = lms[reducedSa[i]];
+    }
+    induce(sortedLms);
+}
+
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::buildLCP(){
+    lcp.assign(_size, 0);
+
+    Array scratch;
+    const Array& reversed = inverse(scratch);
+
+    Index pos = 0;
+
+    for(Index i = 0; i < _size; ++i){
         if(pos > 0){
             --pos;
         }
 
-        if(reversed[i] == _str.size() - 1){
-            lcp[_str.size() - 1] = -1;
+        if(reversed[i] == _size - 1){
+            lcp[_size - 1] = -1;
             pos = 0;
             continue;
         }
 
-        int tmp = suffArray[reversed[i] + 1];
-        while(i + pos < _str.size() && tmp + pos < _str.size() && _str[i + pos] == _str[tmp + pos]){
+        //  терминальный символ встречается один раз, так что '\0' строки
+        //  с ним не совпадает и сравнение обрывается на нем
+        Index tmp = suffArray[reversed[i] + 1];
+        while(i + pos < _size && tmp + pos < _size && symbol(i + pos) == symbol(tmp + pos)){
             pos++;
         }
         lcp[reversed[i]] = pos;
     }
 }
 
-int ProblemSolver::substringsCount(){
-    int res = 0;
-    for(int i = 1; i < _str.size(); ++i){
-        res += _str.size() - suffArray[i] - 1;
+template< class Index, class Array >
+const Array& ProblemSolver< Index, Array >::inverse(Array& scratch) const {
+    if constexpr(!std::is_same< Array, MappedArray< Index > >::value){
+        if(_rank.size() != suffArray.size()){
+            scratch.assign(suffArray.size(), 0);
+            for(Index k = 0; k < suffArray.size(); ++k){
+                scratch[suffArray[k]] = k;
+            }
+            return scratch;
+        }
+    }
+    return _rank;
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::buildLCPIndex(){
+    Array rank;
+    if(&inverse(rank) == &rank){
+        _rank = std::move(rank);
+    }
+    _lcpMinimum = RangeMinimum< Index, Array >(lcp);
+}
+
+template< class Index, class Array >
+Index ProblemSolver< Index, Array >::longestCommonPrefix(Index i, Index j) const {
+    if(i == j){
+        return _size - 1 - i;
+    }
+
+    //  lcp[k] - общий префикс соседей suffArray[k] и suffArray[k + 1],
+    //  для далеких суффиксов берется минимум по отрезку между ними
+    Index first = std::min< Index >(_rank[i], _rank[j]);
+    Index last = std::max< Index >(_rank[i], _rank[j]);
+    return _lcpMinimum.query(lcp, first, last - 1);
+}
+
+template< class Index, class Array >
+int ProblemSolver< Index, Array >::compareSubstrings(Index i, Index len1, Index j, Index len2) const {
+    Index common = std::min(longestCommonPrefix(i, j), std::min(len1, len2));
+    if(common == std::min(len1, len2)){
+        return (len1 < len2) ? -1 : (len1 > len2);
+    }
+    return (symbol(i + common) < symbol(j + common)) ? -1 : 1;
+}
+
+template< class Index, class Array >
+unsigned long long ProblemSolver< Index, Array >::checksum(std::string_view payload){
+    unsigned long long hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for(; i + 8 <= payload.size(); i += 8){
+        unsigned long long word;
+        std::memcpy(&word, payload.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    for(; i < payload.size(); ++i){
+        hash = (hash ^ (unsigned char)payload[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::save(const char* path) const {
+    {
+        std::ofstream out(path, std::ios::binary);
+        if(!out){
+            throw std::runtime_error(std::string("cannot create ") + path);
+        }
+
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.version = FILE_VERSION;
+        header.byteOrder = BYTE_ORDER_MARK;
+        header.indexBytes = sizeof(Index);
+        header.textSize = _str.size();
+        out.write(reinterpret_cast< const char* >(&header), sizeof(header));
+
+        const char padding[8] = {};
+        out.write(_str.data(), _str.size());
+        out.write(padding, (8 - _str.size() % 8) % 8);
+
+        //  массивы пишутся кусками через буфер Index, чтобы PackedArray
+        //  и std::vector давали один и тот же формат
+        Array scratch;
+        const Array* arrays[] = {&suffArray, &lcp, &inverse(scratch)};
+        std::vector< Index > buffer;
+        for(const Array* array : arrays){
+            for(Index begin = 0; begin < _size; begin += 1 << 16){
+                Index end = std::min< Index >(_size, begin + (1 << 16));
+                buffer.resize(end - begin);
+                for(Index i = begin; i < end; ++i){
+                    buffer[i - begin] = (*array)[i];
+                }
+                out.write(reinterpret_cast< const char* >(buffer.data()), buffer.size() * sizeof(Index));
+            }
+            out.write(padding, (8 - _size * sizeof(Index) % 8) % 8);
+        }
+
+        if(!out.flush()){
+            throw std::runtime_error(std::string("cannot write ") + path);
+        }
+    }
+
+    //  контрольная сумма считается по уже записанному файлу и дописывается
+    //  в заголовок
+    unsigned long long sum;
+    {
+        MappedInput written(path);
+        sum = checksum(written.data().substr(sizeof(FileHeader)));
+    }
+
+    std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(offsetof(FileHeader, checksum));
+    out.write(reinterpret_cast< const char* >(&sum), sizeof(sum));
+    if(!out.flush()){
+        throw std::runtime_error(std::string("cannot write ") + path);
+    }
+}
+
+template< class Index, class Array >
+ProblemSolver< Index, Array > ProblemSolver< Index, Array >::load(const char* path, bool verify){
+    ProblemSolver solver;
+    solver._file.reset(new MappedInput(path));
+    std::string_view data = solver._file->data();
+
+    FileHeader header;
+    if(data.size() < sizeof(header)){
+        throw std::runtime_error(std::string(path) + ": file is too short");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if(std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+       header.byteOrder != BYTE_ORDER_MARK){
+        throw std::runtime_error(std::string(path) + ": not a suffix array index");
+    }
+    if(header.version != FILE_VERSION){
+        throw std::runtime_error(std::string(path) + ": unsupported version " + std::to_string(header.version));
+    }
+    if(header.indexBytes != sizeof(Index)){
+        throw std::runtime_error(std::string(path) + ": built with " + std::to_string(header.indexBytes) +
+                                 "-byte indices");
+    }
+
+    auto padded = [](unsigned long long bytes){
+        return bytes + (8 - bytes % 8) % 8;
+    };
+    unsigned long long size = header.textSize + 1;
+    unsigned long long arrayBytes = padded(size * sizeof(Index));
+    if(header.textSize < 0 || data.size() != sizeof(header) + padded(header.textSize) + 3 * arrayBytes){
+        throw std::runtime_error(std::string(path) + ": file is truncated");
+    }
+    if(verify && checksum(data.substr(sizeof(header))) != header.checksum){
+        throw std::runtime_error(std::string(path) + ": checksum mismatch");
+    }
+
+    const char* cursor = data.data() + sizeof(header);
+    solver._str = std::string_view(cursor, header.textSize);
+    solver._size = size;
+    cursor += padded(header.textSize);
+
+    Array* arrays[] = {&solver.suffArray, &solver.lcp, &solver._rank};
+    for(Array* array : arrays){
+        const Index* begin = reinterpret_cast< const Index* >(cursor);
+        *array = Array(begin, begin + size);
+        cursor += arrayBytes;
+    }
+
+    return solver;
+}
+
+template< class Index, class Array >
+Index ProblemSolver< Index, Array >::match(std::string_view pattern, Index position, Index from) const {
+    Index k = from;
+    while(k < pattern.size() && position + k < _size - 1 && _str[position + k] == pattern[k]){
+        ++k;
+    }
+    return k;
+}
+
+template< class Index, class Array >
+Index ProblemSolver< Index, Array >::searchBound(std::string_view pattern, bool upper, Index from) const {
+    Index m = pattern.size();
+    bool accelerated = !_lcpMinimum.empty();
+
+    //  инвариант: суффикс left не больше pattern, суффикс right больше
+    //  (right == _size - граница за массивом). l и r - их общие префиксы с pattern
+    Index left = from;
+    Index right = _size;
+    Index l = match(pattern, suffArray[left], 0);
+    Index r = 0;
+
+    while(right - left > 1){
+        Index middle = left + (right - left) / 2;
+        Index k;
+
+        if(accelerated && (l > r + LCP_LR_GAP || r > l + LCP_LR_GAP)){
+            //  LCP-LR: сравнение middle с той границей, с которой у pattern
+            //  общий префикс длиннее, решает без чтения символов, пока их LCP
+            //  с middle отличается от этого префикса
+            if(l > r){
+                Index common = _lcpMinimum.query(lcp, left, middle - 1);
+                if(common > l){
+                    left = middle;
+                    continue;
+                }
+                if(common < l){
+                    right = middle;
+                    r = common;
+                    continue;
+                }
+                k = match(pattern, suffArray[middle], l);
+            } else {
+                Index common = _lcpMinimum.query(lcp, middle, right - 1);
+                if(common > r){
+                    right = middle;
+                    continue;
+                }
+                if(common < r){
+                    left = middle;
+                    l = common;
+                    continue;
+                }
+                k = match(pattern, suffArray[middle], r);
+            }
+        } else {
+            //  без индекса: символы до min(l, r) совпадают у всего отрезка
+            k = match(pattern, suffArray[middle], std::min(l, r));
+        }
+
+        Index position = suffArray[middle];
+        bool greater = (k == m) ? !upper
+                                : position + k < _size - 1 && (unsigned char)_str[position + k] > (unsigned char)pattern[k];
+        if(greater){
+            right = middle;
+            r = k;
+        } else {
+            left = middle;
+            l = k;
+        }
+    }
+    return right;
+}
+
+template< class Index, class Array >
+Index ProblemSolver< Index, Array >::count(std::string_view pattern) const {
+    if(pattern.empty()){
+        return _size;
+    }
+    return searchBound(pattern, true) - searchBound(pattern, false);
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::locate(std::string_view pattern, std::vector< Index >& positions) const {
+    Index begin = pattern.empty() ? 0 : searchBound(pattern, false);
+    Index end = pattern.empty() ? _size : searchBound(pattern, true);
+
+    positions.clear();
+    for(Index k = begin; k < end; ++k){
+        positions.push_back(suffArray[k]);
+    }
+    std::sort(positions.begin(), positions.end());
+}
+
+template< class Index, class Array >
+void ProblemSolver< Index, Array >::countBatch(const std::vector< std::string_view >& patterns, std::vector< Index >& counts) const {
+    std::vector< int > order(patterns.size());
+    for(int q = 0; q < order.size(); ++q){
+        order[q] = q;
     }
-    for(int i = 0; i < _str.size() - 2; ++i){
+    std::sort(order.begin(), order.end(), [&](int a, int b){
+        return patterns[a] < patterns[b];
+    });
+
+    //  для шаблонов по возрастанию нижняя граница не убывает, а суффикс
+    //  перед ней меньше и этого шаблона, и всех следующих
+    counts.assign(patterns.size(), 0);
+    Index lower = 1;
+    for(int q : order){
+        if(patterns[q].empty()){
+            counts[q] = _size;
+            continue;
+        }
+        lower = searchBound(patterns[q], false, lower - 1);
+        counts[q] = searchBound(patterns[q], true, lower - 1) - lower;
+    }
+}
+
+template< class Index, class Array >
+FMIndex< Index > ProblemSolver< Index, Array >::compress(int sampleRate) const {
+    return FMIndex< Index >(_str, suffArray, sampleRate);
+}
+
+template< class Index, class Array >
+long long ProblemSolver< Index, Array >::substringsCount(){
+    long long res = 0;
+    for(Index i = 1; i < _size; ++i){
+        res += _size - suffArray[i] - 1;
+    }
+    for(Index i = 0; i < _size - 2; ++i){
         res -= lcp[i + 1];
     }
     return res;
 }
 
 
-int main()
+int main(int argc, char** argv)
 {
-    std::string str;
-    std::cin >> str;
-
-    ProblemSolver problemSolver(str);
-
-    std::cout << problemSolver.substringsCount();
+    // вход отображается в память, строка - окно на его страницы
+    MappedInput input(argc > 1 ? argv[1] : nullptr);
+
+    std::string_view str = input.next();
+
+    // индексы int, пока строка с терминальным символом в них помещается,
+    // иначе 40-битные, по 5 байт на элемент массива
+    if(str.size() < INT_MAX){
+        ProblemSolver<> problemSolver(str);
+        std::cout << problemSolver.substringsCount();
+    } else {
+        ProblemSolver< long long, PackedArray > problemSolver(str);
+        std::cout << problemSolver.substringsCount();
+    }
 
     return 0;
 }
@@ -0,0 +1,320 @@
+// Замеры построения суффиксного массива: удвоение префиксов против SA-IS,
+// масштабирование параллельного удвоения по числу потоков, цена 64-битных
+// и упакованных 40-битных индексов, пропускная способность запросов LCP,
+// сохранение индекса и загрузка через mmap, поиск шаблонов, FM-индекс.
+//     g++ -std=c++17 -O2 -pthread bench.cpp -o bench && ./bench
+#define main solution_main
+#include "../main.cpp"
+#undef main
+
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+
+#include "../../../common/benchmark.h"
+
+typedef ProblemSolver<> Solver;
+typedef ProblemSolver< long long > WideSolver;
+typedef ProblemSolver< long long, PackedArray > PackedSolver;
+typedef ProblemSolver< int, MappedArray< int > > MappedSolver;
+
+// подобие текста на естественном языке: слова из словаря на 5000 слов
+// с частотами по закону Ципфа, разделенные подчеркиванием
+std::string wordsString(std::mt19937& rng, int size){
+    std::vector< std::string > dictionary;
+    std::vector< double > weights;
+    for(int i = 0; i < 5000; ++i){
+        dictionary.push_back(randomString(rng, 2 + rng() % 9, 26));
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::discrete_distribution< int > zipf(weights.begin(), weights.end());
+
+    std::string result;
+    while(result.size() < size){
+        result += dictionary[zipf(rng)];
+        result += '_';
+    }
+    result.resize(size);
+    return result;
+}
+
+int main()
+{
+    std::mt19937 rng(179);
+    const int SIZE = 2000000;
+
+    std::string inputs[] = {
+        randomString(rng, SIZE, 26),
+        std::string(SIZE, 'a'),
+        randomString(rng, 1000, 4),
+        wordsString(rng, SIZE),
+    };
+    // период 1000
+    while(inputs[2].size() < SIZE){
+        inputs[2] += inputs[2].substr(0, std::min< size_t >(1000, SIZE - inputs[2].size()));
+    }
+    const char* names[] = {"random a-z", "aaaa...", "period 1000", "words"};
+
+    // сверка способов построения на коротких случайных строках с байтом '\0':
+    // одинаковый суффиксный массив с пустым суффиксом первым и число
+    // различных подстрок, как у перебора
+    {
+        bool same = true;
+        for(int test = 0; test < 2000; ++test){
+            std::string str(rng() % 30, 'a');
+            for(int i = 0; i < str.size(); ++i){
+                str[i] = "\0ab"[rng() % 3];
+            }
+
+            Solver doubling(str, Solver::Engine::Doubling);
+            Solver parallel(str, Solver::Engine::ParallelDoubling, 1 + test % 3);
+            Solver induced(str, Solver::Engine::InducedSorting);
+
+            std::set< std::string > substrings;
+            for(int i = 0; i < str.size(); ++i){
+                for(int j = i + 1; j <= str.size(); ++j){
+                    substrings.insert(str.substr(i, j - i));
+                }
+            }
+
+            same &= doubling.suffixArray() == induced.suffixArray() &&
+                    parallel.suffixArray() == induced.suffixArray() &&
+                    induced.suffixArray()[0] == str.size() &&
+                    doubling.substringsCount() == substrings.size() &&
+                    parallel.substringsCount() == substrings.size() &&
+                    induced.substringsCount() == substrings.size();
+        }
+        std::cout << "engines on random strings with '\\0': " << (same ? "ok" : "MISMATCH") << "\n";
+    }
+
+    std::cout << "input         doubling ms   SA-IS ms   speedup\n";
+    for(int t = 0; t < 4; ++t){
+        auto start = std::chrono::steady_clock::now();
+        Solver doubling(inputs[t], Solver::Engine::Doubling);
+        double doublingTime = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        Solver induced(inputs[t], Solver::Engine::InducedSorting);
+        double inducedTime = seconds(start);
+
+        std::cout << names[t] << "   " << doublingTime * 1e3 << "   " << inducedTime * 1e3 << "   "
+                  << doublingTime / inducedTime
+                  << (doubling.suffixArray() == induced.suffixArray() ? "" : "  MISMATCH") << "\n";
+    }
+
+    // SA-IS с индексами int, long long и 40-битными: время и байт на элемент
+    // массива. сами индексы long long нужны только для строк длиннее 2^31
+    {
+        auto start = std::chrono::steady_clock::now();
+        Solver narrow(inputs[3]);
+        double narrowTime = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        WideSolver wide(inputs[3]);
+        double wideTime = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        PackedSolver packed(inputs[3]);
+        double packedTime = seconds(start);
+
+        bool same = true;
+        for(int i = 0; i < narrow.suffixArray().size(); ++i){
+            same &= narrow.suffixArray()[i] == wide.suffixArray()[i] &&
+                    narrow.suffixArray()[i] == packed.suffixArray()[i];
+        }
+
+        std::cout << "SA-IS on words: int " << narrowTime * 1e3 << " ms (4 B), long long "
+                  << wideTime * 1e3 << " ms (8 B), packed " << packedTime * 1e3 << " ms (5 B)"
+                  << (same ? "" : "  MISMATCH") << "\n";
+    }
+
+    // LCP произвольных суффиксов за O(1): построение индекса и 10^7 запросов
+    // для случайных пар и для пар с близкими рангами
+    {
+        Solver solver(inputs[3]);
+        auto start = std::chrono::steady_clock::now();
+        solver.buildLCPIndex();
+        double buildTime = seconds(start);
+
+        const int QUERIES = 10000000;
+        std::vector< int > first(QUERIES), second(QUERIES);
+        for(int q = 0; q < QUERIES; ++q){
+            first[q] = rng() % SIZE;
+            second[q] = rng() % SIZE;
+        }
+
+        long long checksum = 0;
+        start = std::chrono::steady_clock::now();
+        for(int q = 0; q < QUERIES; ++q){
+            checksum += solver.longestCommonPrefix(first[q], second[q]);
+        }
+        double randomTime = seconds(start);
+
+        const std::vector< int >& sa = solver.suffixArray();
+        for(int q = 0; q < QUERIES; ++q){
+            int rank = rng() % (SIZE - 100);
+            first[q] = sa[rank];
+            second[q] = sa[rank + 1 + rng() % 100];
+        }
+        start = std::chrono::steady_clock::now();
+        for(int q = 0; q < QUERIES; ++q){
+            checksum += solver.longestCommonPrefix(first[q], second[q]);
+        }
+        double nearTime = seconds(start);
+
+        std::cout << "LCP index: build " << buildTime * 1e3 << " ms, random pairs "
+                  << QUERIES / randomTime / 1e6 << " M/s, near ranks " << QUERIES / nearTime / 1e6
+                  << " M/s (checksum " << checksum << ")\n";
+    }
+
+    // индекс на диске: построение против загрузки. load() только отображает
+    // файл, проверка контрольной суммы читает его целиком
+    {
+        auto start = std::chrono::steady_clock::now();
+        Solver built(inputs[3]);
+        double buildTime = seconds(start);
+
+        const char* path = "bench_index.bin";
+        start = std::chrono::steady_clock::now();
+        built.save(path);
+        double saveTime = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        MappedSolver loaded = MappedSolver::load(path);
+        double loadTime = seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        MappedSolver verified = MappedSolver::load(path, true);
+        double verifyTime = seconds(start);
+
+        bool same = built.substringsCount() == loaded.substringsCount();
+        std::remove(path);
+
+        // 40-битные массивы: файл пишется по 8 байт на индекс, load()
+        // упаковывает их обратно
+        PackedSolver packed(inputs[3]);
+        packed.save(path);
+        PackedSolver packedLoaded = PackedSolver::load(path, true);
+        same &= packed.suffixArray() == packedLoaded.suffixArray() &&
+                packed.substringsCount() == packedLoaded.substringsCount();
+        std::remove(path);
+
+        std::cout << "index file: build " << buildTime * 1e3 << " ms, save " << saveTime * 1e3 << " ms, load "
+                  << loadTime * 1e3 << " ms, load with checksum " << verifyTime * 1e3 << " ms"
+                  << (same ? "" : "  MISMATCH") << "\n";
+    }
+
+    // count(): двоичный поиск без LCP-индекса, с ним (LCP-LR) и пачкой
+    // countBatch(). короткие шаблоны из текста слов и длинные из
+    // периодичного текста, где у соседних суффиксов длинные общие префиксы
+    for(int t : {3, 2}){
+        Solver solver(inputs[t]);
+        int minLength = (t == 3) ? 8 : 1000;
+        int maxLength = (t == 3) ? 64 : 5000;
+        int queries = (t == 3) ? 1000000 : 100000;
+
+        std::vector< std::string_view > patterns;
+        for(int q = 0; q < queries; ++q){
+            int length = minLength + rng() % (maxLength - minLength + 1);
+            patterns.push_back(std::string_view(inputs[t]).substr(rng() % (SIZE - length), length));
+        }
+
+        long long plainTotal = 0, indexedTotal = 0, batchTotal = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int q = 0; q < patterns.size(); ++q){
+            plainTotal += solver.count(patterns[q]);
+        }
+        double plainTime = seconds(start);
+
+        solver.buildLCPIndex();
+        start = std::chrono::steady_clock::now();
+        for(int q = 0; q < patterns.size(); ++q){
+            indexedTotal += solver.count(patterns[q]);
+        }
+        double indexedTime = seconds(start);
+
+        std::vector< int > counts;
+        start = std::chrono::steady_clock::now();
+        solver.countBatch(patterns, counts);
+        double batchTime = seconds(start);
+        for(int q = 0; q < counts.size(); ++q){
+            batchTotal += counts[q];
+        }
+
+        std::cout << "count, " << (t == 3 ? "words" : "period 1000") << " m = " << minLength << ".." << maxLength
+                  << ": plain " << queries / plainTime / 1e6 << " M/s, LCP-LR " << queries / indexedTime / 1e6
+                  << " M/s, countBatch " << queries / batchTime / 1e6 << " M/s"
+                  << (plainTotal == indexedTotal && plainTotal == batchTotal ? "" : "  MISMATCH") << "\n";
+    }
+
+    // FM-индекс на тексте слов: память против строки с массивами и время
+    // count / locate для шаблонов длины 8..16 при разном шаге выборки
+    {
+        Solver solver(inputs[3]);
+        size_t plainBytes = SIZE + 2ll * (SIZE + 1) * sizeof(int);
+
+        std::vector< std::string_view > patterns;
+        for(int q = 0; q < 100000; ++q){
+            int length = 8 + rng() % 9;
+            patterns.push_back(std::string_view(inputs[3]).substr(rng() % (SIZE - length), length));
+        }
+
+        std::vector< int > positions;
+        long long plainFound = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int q = 0; q < patterns.size(); ++q){
+            solver.locate(patterns[q], positions);
+            plainFound += positions.size();
+        }
+        std::cout << "suffix array: " << plainBytes / 1e6 << " MB, locate " << seconds(start) * 1e6 / patterns.size()
+                  << " us (" << plainFound << " occurrences)\n";
+
+        for(int rate : {4, 16, 64}){
+            start = std::chrono::steady_clock::now();
+            FMIndex< int > index = solver.compress(rate);
+            double buildTime = seconds(start);
+
+            long long counted = 0;
+            start = std::chrono::steady_clock::now();
+            for(int q = 0; q < patterns.size(); ++q){
+                counted += index.count(patterns[q]);
+            }
+            double countTime = seconds(start);
+
+            long long found = 0;
+            start = std::chrono::steady_clock::now();
+            for(int q = 0; q < patterns.size(); ++q){
+                index.locate(patterns[q], positions);
+                found += positions.size();
+            }
+            double locateTime = seconds(start);
+
+            std::cout << "FM-index, sample rate " << rate << ": " << index.memoryUsage() / 1e6 << " MB, build "
+                      << buildTime * 1e3 << " ms, count " << countTime * 1e6 / patterns.size() << " us, locate "
+                      << locateTime * 1e6 / patterns.size() << " us"
+                      << (counted == plainFound && found == plainFound ? "" : "  MISMATCH") << "\n";
+        }
+    }
+
+    // параллельное удвоение на 10^7 символов Ципфовых слов, 1..64 потока;
+    // ускорение считается от последовательного удвоения
+    std::string large = wordsString(rng, 10000000);
+
+    auto start = std::chrono::steady_clock::now();
+    Solver sequential(large, Solver::Engine::Doubling);
+    double sequentialTime = seconds(start);
+    std::cout << "doubling on " << large.size() << " chars: " << sequentialTime * 1e3 << " ms\n";
+
+    for(int threads = 1; threads <= 64; threads *= 2){
+        start = std::chrono::steady_clock::now();
+        Solver parallel(large, Solver::Engine::ParallelDoubling, threads);
+        double time = seconds(start);
+
+        std::cout << "ParallelDoubling(" << threads << "): " << time * 1e3 << " ms, speedup "
+                  << sequentialTime / time
+                  << (parallel.suffixArray() == sequential.suffixArray() ? "" : "  MISMATCH") << "\n";
+    }
+
+    return 0;
+}
@@ -6,82 +6,163 @@
     developed by Crashdown
     
 */
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 
+#include "../../common/mappedinput.h"
+#include "../../common/paralleldoubling.h"
+#include "../../common/rankbitvector.h"
+
+//  Обобщенный суффиксный массив над N документами. документы склеиваются
+//  через разделители, но разделитель документа d - не байт, а символ d
+//  алфавита N + 256, меньший всех байтов (байт c - символ N + c). все
+//  разделители разные, поэтому никакой байт текста с ними не совпадает,
+//  общие префиксы не переходят через границы документов, а порядок
+//  циклических сдвигов совпадает с порядком суффиксов
 class ProblemSolver{
 
 public:
-    ProblemSolver(std::string& str1, std::string& str2);
+    // threads > 1 - суффиксный массив строится параллельным удвоением.
+    // документов не больше MAX_DOCUMENTS, иначе std::length_error
+    ProblemSolver(const std::vector< std::string_view >& documents, int threads = 1);
+    ProblemSolver(std::string_view str1, std::string_view str2, int threads = 1);
+
+    // k-я в лексикографическом порядке непустая строка, которая встречается
+    // хотя бы в q документах, или "-1", если таких строк меньше k
+    void kCommonSubstring(long long k, int q, std::string& result);
 
+    // то же для строк, общих для всех документов
     void kCommonSubstring(long long k, std::string& result);
 
+    // номер документа хранится в 2 байтах
+    static const int MAX_DOCUMENTS = 1 << 16;
+
 private:
+    //  документы подряд, на местах разделителей - '\0'
     std::string _str;
 
-    int len = 0;
+    int _documents = 0;
+    //  отмечены позиции разделителей. номер документа позиции - число
+    //  разделителей до нее, так его получает symbol() при построении
+    RankBitVector _separators;
 
     std::vector< int > suffArray;
     std::vector< int > lcp;
+    //  номер документа суффикса по рангу: скользящее окно читает его подряд
+    std::vector< unsigned short > _document;
 
-    void buildSuffArray();
+    int document(int position) const;
+    int symbol(int i) const;
+
+    void buildSuffArray(int threads);
     void buildLCP();
 };
 
 
-ProblemSolver::ProblemSolver(std::string& str1, std::string& str2) : _str(str1){
-    _str += "$" + str2 + "#";
+ProblemSolver::ProblemSolver(const std::vector< std::string_view >& documents, int threads){
+    _documents = documents.size();
+    if(_documents > MAX_DOCUMENTS){
+        throw std::length_error("too many documents");
+    }
+
+    size_t total = 0;
+    for(int d = 0; d < _documents; ++d){
+        total += documents[d].size() + 1;
+    }
 
-    len = str1.size();
+    //  склейка все равно нужна, поэтому копируем документы один раз сразу в нее
+    _str.reserve(total);
+    _separators = RankBitVector(total);
+    for(int d = 0; d < _documents; ++d){
+        _str += documents[d];
+        _separators.set(_str.size());
+        _str += '\0';
+    }
+    _separators.buildRank();
 
-    buildSuffArray();
-    buildLCP();
+    if(_documents > 0){
+        buildSuffArray(threads);
+        buildLCP();
+    }
 }
 
-void ProblemSolver::buildSuffArray(){
+ProblemSolver::ProblemSolver(std::string_view str1, std::string_view str2, int threads)
+    : ProblemSolver(std::vector< std::string_view >{str1, str2}, threads) {}
+
+int ProblemSolver::document(int position) const {
+    return _separators.rank1(position);
+}
+
+int ProblemSolver::symbol(int i) const {
+    return _separators.get(i) ? document(i) : _documents + (unsigned char)_str[i];
+}
+
+void ProblemSolver::buildSuffArray(int threads){
+
+    int size = _str.size();
+    const int ALPHABET = _documents + 256;
+    if(threads > 1){
+        int bits = 0;
+        while((1 << bits) < ALPHABET){
+            ++bits;
+        }
+        ParallelDoubling(threads).build(size, [this](int i){ return symbol(i); }, suffArray, bits);
+        return;
+    }
 
     int numEqClasses = 1;
-    std::vector< int > perm(_str.size());
-    std::vector< int > eqClasses(_str.size());
+    std::vector< int > perm(size);
+    std::vector< int > eqClasses(size);
 
-    //  выпонляем нулевыю фазу алгоритма сортировкой подсчетом
-    std::vector< int > cnt(1e6, 0);
+    //  буферы shifted и nextClasses заводятся один раз на все фазы. в нулевой
+    //  фазе nextClasses хранит символы, номера разделителей считаются подряд
+    std::vector< int > shifted(size);
+    std::vector< int > nextClasses(size);
 
-    for(int i = 0; i < _str.size(); ++i){
-        ++cnt[_str[i]];
+    int current = 0;
+    for(int i = 0; i < size; ++i){
+        nextClasses[i] = _separators.get(i) ? current++ : _documents + (unsigned char)_str[i];
     }
 
-    for(int i = 1; i < 1e6; ++i){
+    //  выполняем нулевую фазу алгоритма сортировкой подсчетом по символам.
+    //  тот же массив счетчиков служит всем фазам, где классов бывает до size
+    std::vector< int > cnt(std::max(ALPHABET, size), 0);
+
+    for(int i = 0; i < size; ++i){
+        ++cnt[nextClasses[i]];
+    }
+
+    for(int i = 1; i < ALPHABET; ++i){
         cnt[i] += cnt[i - 1];
     }
 
-    for(int i = 0; i < _str.size(); ++i){
-        perm[--cnt[_str[i]]] = i;
+    for(int i = 0; i < size; ++i){
+        perm[--cnt[nextClasses[i]]] = i;
     }
 
     eqClasses[perm[0]] = 0;
-    for(int i = 1; i < _str.size(); ++i){
-        if(_str[perm[i]] != _str[perm[i - 1]]){
+    for(int i = 1; i < size; ++i){
+        if(nextClasses[perm[i]] != nextClasses[perm[i - 1]]){
             ++numEqClasses;
         }
         eqClasses[perm[i]] = numEqClasses - 1;
     }
 
-    //  итеративно выполняем остальные фазы алгоритма, используя для
-    //  временного хранения данных новой итерации массивы
-    //  _perm_tmp и _eqClasses_tmp
+    //  итеративно выполняем остальные фазы алгоритма. классы новой фазы
+    //  пишутся в nextClasses и меняются местами с eqClasses. как только все
+    //  классы различны, порядок окончательный и следующие фазы его не меняют
 
-    for(int i = 0; (1 << i) < _str.size(); ++i){
-        std::vector< int > _perm_tmp(_str.size());
-        std::vector< int > _eqClasses_tmp(_str.size());
+    for(int shift = 1; shift < size && numEqClasses < size; shift <<= 1){
+        for(int j = 0; j < size; ++j){
+            shifted[j] = perm[j] - shift;
 
-        for(int j = 0; j < _str.size(); ++j){
-            _perm_tmp[j] = perm[j] - (1 << i);
-
-            if(_perm_tmp[j] < 0){
-                _perm_tmp[j] += _str.size();
+            if(shifted[j] < 0){
+                shifted[j] += size;
             }
         }
 
@@ -89,33 +170,35 @@ void ProblemSolver::buildSuffArray(){
             cnt[j] = 0;
         }
 
-        for(int j = 0; j < _str.size(); ++j){
-            ++cnt[eqClasses[_perm_tmp[j]]];
+        for(int j = 0; j < size; ++j){
+            ++cnt[eqClasses[shifted[j]]];
         }
 
         for(int j = 1; j < numEqClasses; ++j){
             cnt[j] += cnt[j - 1];
         }
 
-        for(int j = _str.size() - 1; j >= 0; --j){
-            perm[--cnt[eqClasses[_perm_tmp[j]]]] = _perm_tmp[j];
+        for(int j = size - 1; j >= 0; --j){
+            perm[--cnt[eqClasses[shifted[j]]]] = shifted[j];
         }
 
 
-        _eqClasses_tmp[perm[0]] = 0;
+        nextClasses[perm[0]] = 0;
         numEqClasses = 1;
 
-        for(int j = 1; j < _str.size(); ++j){
-            int tmp1 = (perm[j] + (1 << i)) % _str.size();
-            int tmp2 = (perm[j - 1] + (1 << i)) % _str.size();
+        for(int j = 1; j < size; ++j){
+            int tmp1 = perm[j] + shift;
+            int tmp2 = perm[j - 1] + shift;
+            tmp1 -= (tmp1 >= size) ? size : 0;
+            tmp2 -= (tmp2 >= size) ? size : 0;
             if(eqClasses[perm[j]] != eqClasses[perm[j - 1]] ||
                eqClasses[tmp1] != eqClasses[tmp2]){
                 ++numEqClasses;
             }
-            _eqClasses_tmp[perm[j]] = numEqClasses - 1;
+            nextClasses[perm[j]] = numEqClasses - 1;
         }
 
-        eqClasses = std::move(_eqClasses_tmp);
+        eqClasses.swap(nextClasses);
     }
 
     suffArray = std::move(perm);
@@ -131,8 +214,13 @@ void ProblemSolver::buildLCP(){
     }
 
     int pos = 0;
+    int current = 0;
+    _document.resize(_str.size());
 
     for(int i = 0; i < _str.size(); ++i){
+        _document[reversed[i]] = current;
+        current += _separators.get(i) ? 1 : 0;
+
         if(pos > 0){
             --pos;
         }
@@ -144,58 +232,105 @@ void ProblemSolver::buildLCP(){
         }
 
         int tmp = suffArray[reversed[i] + 1];
-        while(i + pos < _str.size() && tmp + pos < _str.size() && _str[i + pos] == _str[tmp + pos]){
+        //  разделители все разные, так что совпадение обрывается на первом
+        //  из них, и до конца склейки, которая кончается разделителем, не доходит
+        while(!_separators.get(i + pos) && !_separators.get(tmp + pos) && _str[i + pos] == _str[tmp + pos]){
             pos++;
         }
         lcp[reversed[i]] = pos;
     }
 }
 
-void ProblemSolver::kCommonSubstring(long long k, std::string& result){
+void ProblemSolver::kCommonSubstring(long long k, int q, std::string& result){
+    //  новые подстроки ранга i - префиксы его суффикса длиннее lcp[i - 1].
+    //  префикс длины L встречается в q документах, если в q документах лежат
+    //  суффиксы отрезка рангов [i, end), где end - первый ранг, после которого
+    //  их набирается q, а L не больше минимума lcp на этом отрезке. end с
+    //  ростом i не убывает, поэтому отрезок - скользящее окно: по нему
+    //  считаются документы и минимум lcp (монотонной очередью). ранги
+    //  0..N-1 занимают пустые суффиксы из одного разделителя
+    q = std::max(q, 1);
+    result.clear();
+    if(q > _documents){
+        result = "-1";
+        return;
+    }
+
     //  счетчик количества общих подстрок
     long long cnt = 0ll;
 
-    int min = _str.size();
-    //  поддерживаем номер строки из конкатенации к которой относятся
-    //  текущий и предыдущий суффиксы
-    int current = 0;
-    int last = (suffArray[0] > len) ? 2 : 1;
-
-    for(int i = 1; i < suffArray.size(); ++i){
-        current = (suffArray[i] > len) ? 2 : 1;
+    std::vector< int > inWindow(_documents, 0);
+    int distinct = 0;
+    int size = suffArray.size();
+    //  индексы lcp окна [i, end - 1) с возрастающими значениями - очередь
+    //  minimum[head, tail). индекс попадает в нее не больше одного раза
+    std::vector< int > minimum(size);
+    int head = 0;
+    int tail = 0;
+    int end = _documents;
+
+    for(int i = _documents; i < size; ++i){
+        while(end < size && distinct < q){
+            if(inWindow[_document[end]]++ == 0){
+                ++distinct;
+            }
+            if(end > i){
+                while(tail > head && lcp[minimum[tail - 1]] >= lcp[end - 1]){
+                    --tail;
+                }
+                minimum[tail++] = end - 1;
+            }
+            ++end;
+        }
+        if(distinct < q){
+            break;
+        }
 
-        //  суммируем общие подстроки
-        if(current != last){
-            cnt += std::max(0, lcp[i - 1] - min);
-            min = lcp[i - 1];
+        //  при q == 1 окно из одного суффикса, его длина - до разделителя
+        int longest = 0;
+        if(tail == head){
+            while(!_separators.get(suffArray[i] + longest)){
+                ++longest;
+            }
         } else {
-            min = std::min(min, lcp[i - 1]);
+            longest = lcp[minimum[head]];
         }
 
-        last = current;
+        //  суммируем общие подстроки
+        cnt += std::max(0, longest - lcp[i - 1]);
 
-        //  убираем то что прибавили лишнее
+        //  берем из добавленных ровно столько, сколько не хватало до k
         if(cnt >= k){
-            for(int j = 0; j < lcp[i - 1] + k - cnt; ++j){
-                result += _str[suffArray[i] + j];
-            }
+            result.assign(_str, suffArray[i], longest - (cnt - k));
             return;
         }
+
+        if(--inWindow[_document[i]] == 0){
+            --distinct;
+        }
+        if(tail > head && minimum[head] == i){
+            ++head;
+        }
     }
 
     result = "-1";
     return;
 }
 
-int main()
+void ProblemSolver::kCommonSubstring(long long k, std::string& result){
+    kCommonSubstring(k, _documents, result);
+}
+
+int main(int argc, char** argv)
 {
-    std::string str1, str2;
-    std::cin >> str1 >> str2;
+    MappedInput input(argc > 1 ? argv[1] : nullptr);
+
+    std::string_view str1 = input.next();
+    std::string_view str2 = input.next();
 
     ProblemSolver problemSolver(str1, str2);
 
-    long long k;
-    std::cin >> k;
+    long long k = input.nextNumber();
 
     std::string result;
     problemSolver.kCommonSubstring(k, result);
@@ -0,0 +1,123 @@
+// Задержка одного запроса на коротких строках: построение суффиксного
+// массива склейки и поиск k-й общей подстроки. Обобщенный суффиксный массив
+// на тысячах документов: k-я подстрока, общая для q из N.
+//     g++ -std=c++17 -O2 -pthread bench.cpp -o bench && ./bench
+#define main solution_main
+#include "../main.cpp"
+#undef main
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
+#include "../../../common/benchmark.h"
+
+int main()
+{
+    std::mt19937 rng(179);
+
+    // сверка с перебором: k-я подстрока, общая для q из N документов, на
+    // коротких случайных документах, в том числе с q < N и байтом '\0'
+    {
+        bool same = true;
+        for(int test = 0; test < 1000; ++test){
+            int documents = 1 + rng() % 5;
+            std::vector< std::string > texts;
+            std::vector< std::string_view > views;
+            for(int d = 0; d < documents; ++d){
+                texts.push_back(randomString(rng, rng() % 12, 1 + test % 3));
+                if(test % 4 == 0 && !texts.back().empty()){
+                    texts.back()[rng() % texts.back().size()] = '\0';
+                }
+            }
+            for(int d = 0; d < documents; ++d){
+                views.push_back(texts[d]);
+            }
+
+            //  подстрока -> в скольких документах она есть
+            std::map< std::string, int > occurrences;
+            for(int d = 0; d < documents; ++d){
+                std::set< std::string > own;
+                for(int i = 0; i < texts[d].size(); ++i){
+                    for(int j = i + 1; j <= texts[d].size(); ++j){
+                        own.insert(texts[d].substr(i, j - i));
+                    }
+                }
+                for(const std::string& substring : own){
+                    ++occurrences[substring];
+                }
+            }
+
+            ProblemSolver problemSolver(views, 1 + test % 2);
+            for(int q = 1; q <= documents; ++q){
+                std::vector< std::string > common;
+                for(const auto& entry : occurrences){
+                    if(entry.second >= q){
+                        common.push_back(entry.first);
+                    }
+                }
+                for(int k = 1; k <= common.size() + 1; ++k){
+                    std::string result;
+                    problemSolver.kCommonSubstring(k, q, result);
+                    same &= result == (k <= common.size() ? common[k - 1] : "-1");
+                }
+            }
+        }
+        std::cout << "k-th substring common to q of N, brute force check: " << (same ? "ok" : "MISMATCH") << "\n";
+    }
+
+    for(int length = 10; length <= 1000; length *= 10){
+        const int QUERIES = 20000;
+        std::vector< std::string > first, second;
+        for(int q = 0; q < QUERIES; ++q){
+            first.push_back(randomString(rng, length, 4));
+            second.push_back(randomString(rng, length, 4));
+        }
+
+        // контрольная сумма длин ответов, чтобы запросы не выбросил оптимизатор
+        long long checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int q = 0; q < QUERIES; ++q){
+            ProblemSolver problemSolver(first[q], second[q]);
+
+            std::string result;
+            problemSolver.kCommonSubstring(1 + q % length, result);
+            checksum += result.size();
+        }
+        double time = seconds(start);
+
+        std::cout << "|s| = |t| = " << length << ": " << time / QUERIES * 1e6 << " us per query"
+                  << " (checksum " << checksum << ")\n";
+    }
+
+    // N документов - случайные куски длины 500 общего текста длины 20000,
+    // так что у больших групп документов есть длинные общие подстроки
+    for(int documents : {100, 1000, 5000}){
+        std::string source = randomString(rng, 20000, 4);
+        std::vector< std::string > texts;
+        std::vector< std::string_view > views;
+        for(int d = 0; d < documents; ++d){
+            texts.push_back(source.substr(rng() % (source.size() - 500), 500));
+        }
+        for(int d = 0; d < documents; ++d){
+            views.push_back(texts[d]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ProblemSolver problemSolver(views);
+        double buildTime = seconds(start);
+
+        std::cout << "N = " << documents << ", " << documents * 501 << " chars: build " << buildTime * 1e3 << " ms";
+        for(int q : {2, documents / 10, documents / 2}){
+            std::string result;
+            start = std::chrono::steady_clock::now();
+            problemSolver.kCommonSubstring(1000, q, result);
+            std::cout << ", q = " << q << " " << seconds(start) * 1e3 << " ms (|answer| " << result.size() << ")";
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}